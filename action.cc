@@ -32,18 +32,18 @@
  */
 ModelAction::ModelAction(action_type_t type, memory_order order, void *loc,
 												 uint64_t value, Thread *thread) :
-	location(loc),
-	position(NULL),
-	reads_from(NULL),
-	last_fence_release(NULL),
+	seq_number(ACTION_INITIAL_CLOCK),
 	cv(NULL),
-	rf_cv(NULL),
-	action_ref(NULL),
+	reads_from(NULL),
+	location(loc),
 	value(value),
 	type(type),
 	order(order),
 	original_order(order),
-	seq_number(ACTION_INITIAL_CLOCK)
+	last_fence_release(NULL),
+	rf_cv(NULL),
+	action_ref(NULL),
+	position(NULL)
 {
 	/* References to NULL atomic variables can end up here */
 	ASSERT(loc || type == ATOMIC_FENCE || type == ATOMIC_NOP);
@@ -64,18 +64,18 @@ ModelAction::ModelAction(action_type_t type, memory_order order, void *loc,
  * @param _time The this sleep action is constructed
  */
 ModelAction::ModelAction(action_type_t type, memory_order order, uint64_t value, uint64_t _time) :
-	location(NULL),
-	position(NULL),
-	time(_time),
-	last_fence_release(NULL),
+	seq_number(ACTION_INITIAL_CLOCK),
 	cv(NULL),
-	rf_cv(NULL),
-	action_ref(NULL),
+	time(_time),
+	location(NULL),
 	value(value),
 	type(type),
 	order(order),
 	original_order(order),
-	seq_number(ACTION_INITIAL_CLOCK)
+	last_fence_release(NULL),
+	rf_cv(NULL),
+	action_ref(NULL),
+	position(NULL)
 {
 	Thread *t = thread_current();
 	this->tid = t!= NULL ? t->get_id() : -1;
@@ -95,18 +95,18 @@ ModelAction::ModelAction(action_type_t type, memory_order order, uint64_t value,
  */
 ModelAction::ModelAction(action_type_t type, memory_order order, void *loc,
 												 uint64_t value, int size) :
-	location(loc),
-	position(NULL),
-	reads_from(NULL),
-	last_fence_release(NULL),
+	seq_number(ACTION_INITIAL_CLOCK),
 	cv(NULL),
-	rf_cv(NULL),
-	action_ref(NULL),
+	reads_from(NULL),
+	location(loc),
 	value(value),
 	type(type),
 	order(order),
 	original_order(order),
-	seq_number(ACTION_INITIAL_CLOCK)
+	last_fence_release(NULL),
+	rf_cv(NULL),
+	action_ref(NULL),
+	position(NULL)
 {
 	/* References to NULL atomic variables can end up here */
 	ASSERT(loc);
@@ -129,18 +129,18 @@ ModelAction::ModelAction(action_type_t type, memory_order order, void *loc,
  */
 ModelAction::ModelAction(action_type_t type, const char * position, memory_order order, void *loc,
 												 uint64_t value, int size) :
-	location(loc),
-	position(position),
-	reads_from(NULL),
-	last_fence_release(NULL),
+	seq_number(ACTION_INITIAL_CLOCK),
 	cv(NULL),
-	rf_cv(NULL),
-	action_ref(NULL),
+	reads_from(NULL),
+	location(loc),
 	value(value),
 	type(type),
 	order(order),
 	original_order(order),
-	seq_number(ACTION_INITIAL_CLOCK)
+	last_fence_release(NULL),
+	rf_cv(NULL),
+	action_ref(NULL),
+	position(position)
 {
 	/* References to NULL atomic variables can end up here */
 	ASSERT(loc);
@@ -164,18 +164,18 @@ ModelAction::ModelAction(action_type_t type, const char * position, memory_order
  */
 ModelAction::ModelAction(action_type_t type, const char * position, memory_order order,
 												 void *loc, uint64_t value, Thread *thread) :
-	location(loc),
-	position(position),
-	reads_from(NULL),
-	last_fence_release(NULL),
+	seq_number(ACTION_INITIAL_CLOCK),
 	cv(NULL),
-	rf_cv(NULL),
-	action_ref(NULL),
+	reads_from(NULL),
+	location(loc),
 	value(value),
 	type(type),
 	order(order),
 	original_order(order),
-	seq_number(ACTION_INITIAL_CLOCK)
+	last_fence_release(NULL),
+	rf_cv(NULL),
+	action_ref(NULL),
+	position(position)
 {
 	/* References to NULL atomic variables can end up here */
 	ASSERT(loc || type == ATOMIC_FENCE);
@@ -234,12 +234,12 @@ bool ModelAction::is_thread_join() const
 
 bool ModelAction::is_mutex_op() const
 {
-	return type == ATOMIC_LOCK || type == ATOMIC_TRYLOCK || type == ATOMIC_UNLOCK || type == ATOMIC_WAIT || type == ATOMIC_TIMEDWAIT || type == ATOMIC_NOTIFY_ONE || type == ATOMIC_NOTIFY_ALL;
+	return type == ATOMIC_LOCK || type == ATOMIC_TRYLOCK || type == ATOMIC_TIMEDLOCK || type == ATOMIC_UNLOCK || type == ATOMIC_WAIT || type == ATOMIC_TIMEDWAIT || type == ATOMIC_NOTIFY_ONE || type == ATOMIC_NOTIFY_ALL;
 }
 
 bool ModelAction::is_lock() const
 {
-	return type == ATOMIC_LOCK;
+	return type == ATOMIC_LOCK || type == ATOMIC_TIMEDLOCK;
 }
 
 bool ModelAction::is_sleep() const
@@ -247,6 +247,23 @@ bool ModelAction::is_sleep() const
 	return type == THREAD_SLEEP;
 }
 
+/** @return True if this is a lock or wait that gives up at a deadline */
+bool ModelAction::is_timed() const
+{
+	return type == ATOMIC_TIMEDLOCK || type == ATOMIC_TIMEDWAIT;
+}
+
+/**
+ * @return The virtual time at which this sleep ends, or at which this timed
+ * lock or wait times out
+ */
+uint64_t ModelAction::get_wakeup_time() const
+{
+	if (is_sleep())
+		return time + value;
+	return time;
+}
+
 bool ModelAction::is_wait() const {
 	return type == ATOMIC_WAIT || type == ATOMIC_TIMEDWAIT;
 }
@@ -271,7 +288,7 @@ bool ModelAction::is_trylock() const
 
 bool ModelAction::is_success_lock() const
 {
-	return type == ATOMIC_LOCK || (type == ATOMIC_TRYLOCK && value == VALUE_TRYSUCCESS);
+	return is_lock() || (type == ATOMIC_TRYLOCK && value == VALUE_TRYSUCCESS);
 }
 
 bool ModelAction::is_failed_trylock() const
@@ -689,6 +706,7 @@ const char * ModelAction::get_type_str() const
 	case ATOMIC_LOCK: return "lock";
 	case ATOMIC_UNLOCK: return "unlock";
 	case ATOMIC_TRYLOCK: return "trylock";
+	case ATOMIC_TIMEDLOCK: return "timed lock";
 	case ATOMIC_WAIT: return "wait";
 	case ATOMIC_TIMEDWAIT: return "timed wait";
 	case ATOMIC_NOTIFY_ONE: return "notify one";
@@ -71,6 +71,7 @@ typedef enum action_type {
 	ATOMIC_FENCE,	// < A fence action
 	ATOMIC_LOCK,	// < A lock action
 	ATOMIC_TRYLOCK,	// < A trylock action
+	ATOMIC_TIMEDLOCK,	// < A lock action that gives up at a deadline
 	ATOMIC_UNLOCK,	// < An unlock action
 
 	ATOMIC_NOTIFY_ONE,	// < A notify_one action
@@ -102,11 +103,11 @@ public:
 	void print() const;
 
 	thread_id_t get_tid() const { return tid; }
-	action_type get_type() const { return type; }
+	action_type get_type() const { return (action_type) type; }
 	void set_type(action_type _type) { type = _type; }
 	void set_free() { type = READY_FREE; }
-	memory_order get_mo() const { return order; }
-	memory_order get_original_mo() const { return original_order; }
+	memory_order get_mo() const { return (memory_order) order; }
+	memory_order get_original_mo() const { return (memory_order) original_order; }
 	void set_mo(memory_order order) { this->order = order; }
 	void * get_location() const { return location; }
 	const char * get_position() const { return position; }
@@ -117,6 +118,9 @@ public:
 	uint64_t get_return_value() const;
 	ModelAction * get_reads_from() const { return reads_from; }
 	uint64_t get_time() const {return time;}
+	/** @brief Set the virtual time a timed lock or wait gives up at */
+	void set_time(uint64_t _time) { time = _time; }
+	uint64_t get_wakeup_time() const;
 	cdsc::mutex * get_mutex() const;
 
 	void set_read_from(ModelAction *act);
@@ -136,6 +140,7 @@ public:
 	bool is_mutex_op() const;
 	bool is_lock() const;
 	bool is_sleep() const;
+	bool is_timed() const;
 	bool is_trylock() const;
 	bool is_unlock() const;
 	bool is_wait() const;
@@ -190,22 +195,37 @@ public:
 	void set_value(uint64_t val) { value = val; }
 
 	/* to accomodate pthread create and join */
-	Thread * thread_operand;
 	void set_thread_operand(Thread *th) { thread_operand = th; }
 
 	void setActionRef(sllnode<ModelAction *> *ref) { action_ref = ref; }
 	sllnode<ModelAction *> * getActionRef() { return action_ref; }
 
-	SNAPSHOTALLOC
+	SNAPSHOTSLABALLOC(ModelAction)
 private:
 	const char * get_type_str() const;
 	const char * get_mo_str() const;
 
-	/** @brief A pointer to the memory location for this action. */
-	void *location;
+	/*
+	 * Hot fields: the rf-set and modification order loops only look at
+	 * these, so they are packed together at the start of the object.
+	 */
 
-	/** @brief A pointer to the source line for this atomic action. */
-	const char * position;
+	/**
+	 * @brief The sequence number of this action
+	 *
+	 * Except for non atomic write actions, this number should be unique and
+	 * should represent the action's position in the execution order.
+	 */
+	modelclock_t seq_number;
+
+	/**
+	 * @brief The clock vector for this operation
+	 *
+	 * Technically, this is only needed for potentially synchronizing
+	 * (e.g., non-relaxed) operations, but it is very handy to have these
+	 * vectors for all operations.
+	 */
+	ClockVector *cv;
 
 	union {
 		/**
@@ -215,45 +235,40 @@ private:
 		 */
 		ModelAction *reads_from;
 		int size;
-		uint64_t time;	//used for sleep
+		uint64_t time;	//used for sleeps, timed locks and timed waits
 	};
 
-	/** @brief The last fence release from the same thread */
-	const ModelAction *last_fence_release;
-
-	/**
-	 * @brief The clock vector for this operation
-	 *
-	 * Technically, this is only needed for potentially synchronizing
-	 * (e.g., non-relaxed) operations, but it is very handy to have these
-	 * vectors for all operations.
-	 */
-	ClockVector *cv;
-	ClockVector *rf_cv;
-	sllnode<ModelAction *> * action_ref;
+	/** @brief A pointer to the memory location for this action. */
+	void *location;
 
 	/** @brief The value written (for write or RMW; undefined for read) */
 	uint64_t value;
 
+	/** @brief The thread id that performed this action. */
+	thread_id_t tid;
+
 	/** @brief Type of action (read, write, RMW, fence, thread create, etc.) */
-	action_type type;
+	uint8_t type;
 
 	/** @brief The memory order for this operation. */
-	memory_order order;
+	uint8_t order;
 
 	/** @brief The original memory order parameter for this operation. */
-	memory_order original_order;
+	uint8_t original_order;
 
-	/** @brief The thread id that performed this action. */
-	thread_id_t tid;
+	/* Cold fields: release sequences, trace bookkeeping and printing. */
 
-	/**
-	 * @brief The sequence number of this action
-	 *
-	 * Except for non atomic write actions, this number should be unique and
-	 * should represent the action's position in the execution order.
-	 */
-	modelclock_t seq_number;
+	/** @brief The last fence release from the same thread */
+	const ModelAction *last_fence_release;
+
+	ClockVector *rf_cv;
+	sllnode<ModelAction *> * action_ref;
+
+	/** @brief A pointer to the source line for this atomic action. */
+	const char * position;
+
+	/* to accomodate pthread create and join */
+	Thread * thread_operand;
 };
 
 #endif	/* __ACTION_H__ */
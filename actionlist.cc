@@ -154,6 +154,52 @@ void actionlist::addAction(ModelAction * act) {
 
 }
 
+/**
+ * Find the last action whose sequence number is at most clock, using the
+ * index tree rather than walking the list from the tail.
+ * @param clock The sequence number bound
+ * @return The list node of that action, or NULL if there is none
+ */
+sllnode<ModelAction *> * actionlist::findLast(modelclock_t clock) {
+	if (tail == NULL || tail->val->get_seq_number() <= clock)
+		return tail;
+
+	//Walk down the path of clock as far as it exists
+	int shiftbits = MODELCLOCKBITS - ALLBITS;
+	allnode * ptr = &root;
+	while(1) {
+		allnode * tmp = ptr->children[(clock >> shiftbits) & ALLMASK];
+		if (tmp == NULL)
+			break;
+		if (shiftbits == 0)
+			return reinterpret_cast<sllnode<ModelAction *> *>(((uintptr_t)tmp) & ACTMASK);
+		ptr = tmp;
+		shiftbits -= ALLBITS;
+	}
+
+	//Find the closest smaller sibling, going up the tree as needed
+	while(ptr != NULL) {
+		int currindex = (clock >> shiftbits) & ALLMASK;
+		for(int i = currindex - 1;i >= 0;i--) {
+			allnode * tmp = ptr->children[i];
+			if (tmp == NULL)
+				continue;
+			//Take the largest entry below this sibling
+			while(shiftbits != 0) {
+				int j = ALLMASK;
+				while(tmp->children[j] == NULL)
+					j--;
+				tmp = tmp->children[j];
+				shiftbits -= ALLBITS;
+			}
+			return reinterpret_cast<sllnode<ModelAction *> *>(((uintptr_t)tmp) & ACTMASK);
+		}
+		ptr = ptr->parent;
+		shiftbits += ALLBITS;
+	}
+	return NULL;
+}
+
 void decrementCount(allnode * ptr) {
 	ptr->count--;
 	if (ptr->count == 0) {
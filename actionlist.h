@@ -19,7 +19,7 @@ class allnode {
 public:
 	allnode();
 	~allnode();
-	SNAPSHOTALLOC;
+	SNAPSHOTSLABALLOC(allnode);
 
 private:
 	allnode * parent;
@@ -41,6 +41,7 @@ public:
 	uint size() {return _size;}
 	sllnode<ModelAction *> * begin() {return head;}
 	sllnode<ModelAction *> * end() {return tail;}
+	sllnode<ModelAction *> * findLast(modelclock_t clock);
 	void fixupParent();
 
 	SNAPSHOTALLOC;
@@ -3,6 +3,7 @@
 #include <inttypes.h>
 #include "stl-model.h"
 #include "hashset.h"
+#include "hashfunction.h"
 #include "modeltypes.h"
 
 class ClockVector;
@@ -31,6 +32,10 @@ struct bug_message;
 
 typedef SnapList<ModelAction *> simple_action_list_t;
 typedef actionlist action_list_t;
+/** Scratch vector of actions in the execution region (e.g., rf sets) */
+typedef SnapVector<ModelAction *, region_malloc, region_realloc, region_free> scratch_action_vector_t;
+/** Scratch vector of cycle graph nodes in the execution region */
+typedef SnapVector<CycleNode *, region_malloc, region_realloc, region_free> scratch_node_vector_t;
 typedef SnapList<uint32_t> func_id_list_t;
 typedef SnapList<FuncInst *> func_inst_list_t;
 
@@ -38,6 +43,8 @@ typedef HashSet<Predicate *, uintptr_t, 0, model_malloc, model_calloc, model_fre
 typedef HSIterator<Predicate *, uintptr_t, 0, model_malloc, model_calloc, model_free> PredSetIter;
 
 typedef HashSet<uint64_t, uint64_t, 0, snapshot_malloc, snapshot_calloc, snapshot_free> value_set_t;
+typedef HashSet<uint64_t, uint64_t, 0, model_malloc, model_calloc, model_free, int64_hash> behavior_set_t;
+typedef HashTable<uint64_t, unsigned int, uint64_t, 0, model_malloc, model_calloc, model_free, int64_hash> trace_hash_count_t;
 typedef HSIterator<uint64_t, uint64_t, 0, snapshot_malloc, snapshot_calloc, snapshot_free> value_set_iter;
 typedef HashSet<void *, uintptr_t, 0, snapshot_malloc, snapshot_calloc, snapshot_free> loc_set_t;
 typedef HSIterator<void *, uintptr_t, 0, snapshot_malloc, snapshot_calloc, snapshot_free> loc_set_iter;
@@ -1,5 +1,6 @@
 #include "mutex.h"
 #include "model.h"
+#include "execution.h"
 #include <condition_variable>
 #include "action.h"
 
@@ -26,5 +27,19 @@ void condition_variable::wait(mutex& lock) {
 	//relock as a second action
 	lock.lock();
 }
+
+/**
+ * @brief Wait until notified or until the absolute CLOCK_REALTIME deadline
+ * abstime passes on the execution's virtual clock
+ * @return 0 if woken up, ETIMEDOUT if timed out
+ */
+int condition_variable::timed_wait(mutex& lock, const struct timespec *abstime) {
+	ModelAction *wait = new ModelAction(ATOMIC_TIMEDWAIT, std::memory_order_seq_cst, this, (uint64_t) &lock);
+	wait->set_time(model->get_execution()->get_virtual_deadline(abstime));
+	int ret = model->switch_thread(wait);
+	//relock as a second action
+	lock.lock();
+	return ret;
+}
 }
 
@@ -41,9 +41,25 @@
 
 /** Thread parameters */
 
-/* Size of stack to allocate for a thread. */
+/* Default size of stack to allocate for a thread. */
 #define STACK_SIZE (1024 * 1024)
 
+/* Number of thread stacks kept in the shared stack pool. */
+#define STACK_POOL_SLOTS 256
+
+/** Switch between user threads with the hand-written context switch in
+ *  context.cc rather than swapcontext(), where the architecture has one */
+#define FAST_CONTEXT
+
+/** Nanoseconds that pass on an execution's virtual clock with each action */
+#define VIRTUAL_TIME_PER_ACTION 1000
+
+/** Identical reads in a row after which a thread counts as spinning */
+#define SPIN_THRESHOLD 4
+
+/** log2 of the number of entries in the coverage fuzzer's bitmap */
+#define COVERAGE_MAP_BITS 16
+
 /** How many shadow tables of memory to preallocate for data race detector. */
 #define SHADOWBASETABLES 4
 
@@ -25,3 +25,150 @@ int model_swapcontext(ucontext_t *oucp, ucontext_t *ucp)
 }
 
 #endif	/* MAC */
+
+#ifdef HAVE_FAST_CONTEXT
+
+#if defined(__x86_64__)
+
+/*
+ * Frame pushed on a suspended stack, from the stack pointer up: x87 control
+ * word, MXCSR, r15, r14, r13, r12, rbx, rbp, return address.
+ */
+__asm__(
+	"	.pushsection .text\n"
+	"	.globl	model_context_switch\n"
+	"	.type	model_context_switch, @function\n"
+	"model_context_switch:\n"
+	"	pushq	%rbp\n"
+	"	pushq	%rbx\n"
+	"	pushq	%r12\n"
+	"	pushq	%r13\n"
+	"	pushq	%r14\n"
+	"	pushq	%r15\n"
+	"	subq	$16, %rsp\n"
+	"	stmxcsr	8(%rsp)\n"
+	"	fnstcw	(%rsp)\n"
+	"	movq	%rsp, (%rdi)\n"
+	"	movq	%rsi, %rsp\n"
+	".Lmodel_context_restore:\n"
+	"	fldcw	(%rsp)\n"
+	"	ldmxcsr	8(%rsp)\n"
+	"	addq	$16, %rsp\n"
+	"	popq	%r15\n"
+	"	popq	%r14\n"
+	"	popq	%r13\n"
+	"	popq	%r12\n"
+	"	popq	%rbx\n"
+	"	popq	%rbp\n"
+	"	xorl	%eax, %eax\n"
+	"	ret\n"
+	"	.size	model_context_switch, .-model_context_switch\n"
+	"\n"
+	"	.globl	model_context_switch_ucontext\n"
+	"	.type	model_context_switch_ucontext, @function\n"
+	"model_context_switch_ucontext:\n"
+	"	pushq	%rbp\n"
+	"	pushq	%rbx\n"
+	"	pushq	%r12\n"
+	"	pushq	%r13\n"
+	"	pushq	%r14\n"
+	"	pushq	%r15\n"
+	"	subq	$16, %rsp\n"
+	"	stmxcsr	8(%rsp)\n"
+	"	fnstcw	(%rsp)\n"
+	"	movq	%rsp, (%rdi)\n"
+	"	movq	%rsi, %rdi\n"
+	"	subq	$8, %rsp\n"
+	"	call	setcontext@PLT\n"
+	"	ud2\n"
+	"	.size	model_context_switch_ucontext, .-model_context_switch_ucontext\n"
+	"\n"
+	"	.globl	model_context_resume\n"
+	"	.type	model_context_resume, @function\n"
+	"model_context_resume:\n"
+	"	movq	%rdi, %rsp\n"
+	"	jmp	.Lmodel_context_restore\n"
+	"	.size	model_context_resume, .-model_context_resume\n"
+	"	.popsection\n"
+);
+
+#elif defined(__aarch64__)
+
+/*
+ * Frame pushed on a suspended stack, from the stack pointer up: x19-x28,
+ * x29 (frame pointer), x30 (return address), d8-d15, FPCR.
+ */
+__asm__(
+	"	.pushsection .text\n"
+	"	.globl	model_context_switch\n"
+	"	.type	model_context_switch, %function\n"
+	"model_context_switch:\n"
+	"	sub	sp, sp, #176\n"
+	"	stp	x19, x20, [sp, #0]\n"
+	"	stp	x21, x22, [sp, #16]\n"
+	"	stp	x23, x24, [sp, #32]\n"
+	"	stp	x25, x26, [sp, #48]\n"
+	"	stp	x27, x28, [sp, #64]\n"
+	"	stp	x29, x30, [sp, #80]\n"
+	"	stp	d8, d9, [sp, #96]\n"
+	"	stp	d10, d11, [sp, #112]\n"
+	"	stp	d12, d13, [sp, #128]\n"
+	"	stp	d14, d15, [sp, #144]\n"
+	"	mrs	x9, fpcr\n"
+	"	str	x9, [sp, #160]\n"
+	"	mov	x9, sp\n"
+	"	str	x9, [x0]\n"
+	"	mov	sp, x1\n"
+	".Lmodel_context_restore:\n"
+	"	ldp	x19, x20, [sp, #0]\n"
+	"	ldp	x21, x22, [sp, #16]\n"
+	"	ldp	x23, x24, [sp, #32]\n"
+	"	ldp	x25, x26, [sp, #48]\n"
+	"	ldp	x27, x28, [sp, #64]\n"
+	"	ldp	x29, x30, [sp, #80]\n"
+	"	ldp	d8, d9, [sp, #96]\n"
+	"	ldp	d10, d11, [sp, #112]\n"
+	"	ldp	d12, d13, [sp, #128]\n"
+	"	ldp	d14, d15, [sp, #144]\n"
+	"	ldr	x9, [sp, #160]\n"
+	"	msr	fpcr, x9\n"
+	"	add	sp, sp, #176\n"
+	"	mov	w0, #0\n"
+	"	ret\n"
+	"	.size	model_context_switch, .-model_context_switch\n"
+	"\n"
+	"	.globl	model_context_switch_ucontext\n"
+	"	.type	model_context_switch_ucontext, %function\n"
+	"model_context_switch_ucontext:\n"
+	"	sub	sp, sp, #176\n"
+	"	stp	x19, x20, [sp, #0]\n"
+	"	stp	x21, x22, [sp, #16]\n"
+	"	stp	x23, x24, [sp, #32]\n"
+	"	stp	x25, x26, [sp, #48]\n"
+	"	stp	x27, x28, [sp, #64]\n"
+	"	stp	x29, x30, [sp, #80]\n"
+	"	stp	d8, d9, [sp, #96]\n"
+	"	stp	d10, d11, [sp, #112]\n"
+	"	stp	d12, d13, [sp, #128]\n"
+	"	stp	d14, d15, [sp, #144]\n"
+	"	mrs	x9, fpcr\n"
+	"	str	x9, [sp, #160]\n"
+	"	mov	x9, sp\n"
+	"	str	x9, [x0]\n"
+	"	mov	x0, x1\n"
+	"	bl	setcontext\n"
+	"	brk	#0\n"
+	"	.size	model_context_switch_ucontext, .-model_context_switch_ucontext\n"
+	"\n"
+	"	.globl	model_context_resume\n"
+	"	.type	model_context_resume, %function\n"
+	"model_context_resume:\n"
+	"	mov	sp, x0\n"
+	"	b	.Lmodel_context_restore\n"
+	"	.size	model_context_resume, .-model_context_resume\n"
+	"	.popsection\n"
+);
+
+#endif
+
+#endif	/* HAVE_FAST_CONTEXT */
@@ -9,6 +9,8 @@
 #include <ucontext.h>
 #include <stdio.h>
 
+#include "config.h"
+
 #ifdef MAC
 
 int model_swapcontext(ucontext_t *oucp, ucontext_t *ucp);
@@ -22,4 +24,42 @@ static inline int model_swapcontext(ucontext_t *oucp, ucontext_t *ucp)
 
 #endif	/* !MAC */
 
+#if defined(FAST_CONTEXT) && !defined(MAC) && (defined(__x86_64__) || defined(__aarch64__))
+#define HAVE_FAST_CONTEXT 1
+
+/*
+ * A lightweight alternative to swapcontext() for switching between user
+ * threads. A suspended context is just a stack pointer: the callee-saved
+ * registers and the FPU control words are pushed on the suspended stack.
+ * Unlike swapcontext(), no system call is made to save the signal mask, which
+ * all user threads share anyway.
+ */
+extern "C" {
+
+/**
+ * @brief Suspend the current context and resume a suspended one
+ * @param save Where to store the stack pointer of the current context
+ * @param sp The stack pointer of a context suspended by this function
+ * @return 0, when the current context is resumed
+ */
+int model_context_switch(void **save, void *sp);
+
+/**
+ * @brief Suspend the current context and setcontext() to a ucontext
+ * @param save Where to store the stack pointer of the current context
+ * @param ucp A context made by getcontext()/makecontext()/swapcontext()
+ * @return 0, when the current context is resumed
+ */
+int model_context_switch_ucontext(void **save, ucontext_t *ucp);
+
+/**
+ * @brief Resume a suspended context, abandoning the current one
+ * @param sp The stack pointer of a context suspended by model_context_switch()
+ */
+void model_context_resume(void *sp) __attribute__((noreturn));
+
+}
+
+#endif	/* HAVE_FAST_CONTEXT */
+
 #endif	/* __CONTEXT_H__ */
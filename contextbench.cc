@@ -0,0 +1,103 @@
+/**
+ * @file contextbench.cc
+ * @brief Microbenchmark of context switches per second
+ *
+ * Two contexts hand control back and forth, first with swapcontext() and
+ * then with the fast context switch in context.cc, when the architecture
+ * has one. Built standalone with 'make bench', without the model checker.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "context.h"
+
+#define BENCH_STACK_SIZE (64 * 1024)
+#define DEFAULT_ROUNDS 2000000
+
+static ucontext_t main_uc, peer_uc;
+
+/** @return Monotonic time in nanoseconds */
+static uint64_t now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void report(const char *name, unsigned long rounds, uint64_t ns)
+{
+	/* Each round switches to the peer and back */
+	double switches = 2.0 * rounds;
+	printf("%-22s %10.1fM switches/s (%.1f ns/switch)\n", name,
+				 switches * 1000.0 / ns, ns / switches);
+}
+
+static void peer_swapcontext()
+{
+	while (true)
+		swapcontext(&peer_uc, &main_uc);
+}
+
+static void bench_swapcontext(unsigned long rounds, char *stack)
+{
+	getcontext(&peer_uc);
+	peer_uc.uc_stack.ss_sp = stack;
+	peer_uc.uc_stack.ss_size = BENCH_STACK_SIZE;
+	peer_uc.uc_link = NULL;
+	makecontext(&peer_uc, peer_swapcontext, 0);
+
+	uint64_t start = now_ns();
+	for (unsigned long i = 0;i < rounds;i++)
+		swapcontext(&main_uc, &peer_uc);
+	report("swapcontext", rounds, now_ns() - start);
+}
+
+#ifdef HAVE_FAST_CONTEXT
+
+static void *main_sp, *peer_sp;
+
+static void peer_fast()
+{
+	while (true)
+		model_context_switch(&peer_sp, main_sp);
+}
+
+static void bench_fast(unsigned long rounds, char *stack)
+{
+	getcontext(&peer_uc);
+	peer_uc.uc_stack.ss_sp = stack;
+	peer_uc.uc_stack.ss_size = BENCH_STACK_SIZE;
+	peer_uc.uc_link = NULL;
+	makecontext(&peer_uc, peer_fast, 0);
+	/* Enter the peer once, so that it is suspended by the fast switch */
+	model_context_switch_ucontext(&main_sp, &peer_uc);
+
+	uint64_t start = now_ns();
+	for (unsigned long i = 0;i < rounds;i++)
+		model_context_switch(&main_sp, peer_sp);
+	report("model_context_switch", rounds, now_ns() - start);
+}
+
+#endif	/* HAVE_FAST_CONTEXT */
+
+int main(int argc, char **argv)
+{
+	unsigned long rounds = argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_ROUNDS;
+	if (rounds == 0) {
+		fprintf(stderr, "Usage: %s [ROUNDS]\n", argv[0]);
+		return 1;
+	}
+
+	char *stack = (char *)malloc(BENCH_STACK_SIZE);
+	bench_swapcontext(rounds, stack);
+#ifdef HAVE_FAST_CONTEXT
+	bench_fast(rounds, stack);
+#else
+	printf("model_context_switch   not available on this architecture\n");
+#endif
+	free(stack);
+	return 0;
+}
@@ -0,0 +1,250 @@
+#include "coveragefuzzer.h"
+#include <stdlib.h>
+#include "prng.h"
+#include "threads-model.h"
+#include "model.h"
+#include "execution.h"
+#include "action.h"
+#include "cyclegraph.h"
+
+/** One execution in this many ignores the corpus and runs at random */
+#define FRESH_EXECUTION_RATE 8
+
+/** After the cut, a havoc mutant redraws one decision in this many */
+#define HAVOC_RATE 8
+
+corpus_seed::corpus_seed(const SnapVector<unsigned int> *decisions) :
+	length(decisions->size()),
+	decisions((unsigned int *)model_malloc(sizeof(unsigned int) * (decisions->size() + 1))),
+	fuzzed(0)
+{
+	for (unsigned int i = 0;i < length;i++)
+		this->decisions[i] = (*decisions)[i];
+}
+
+corpus_seed::~corpus_seed()
+{
+	model_free(decisions);
+}
+
+CoverageFuzzer::CoverageFuzzer() :
+	execution(NULL),
+	virgin((uint8_t *)model_calloc(COVERAGE_MAP_SIZE, 1)),
+	corpus(new ModelVector<struct corpus_seed *>()),
+	covered((unsigned int *)model_calloc(1, sizeof(unsigned int))),
+	started(false),
+	seed(NULL),
+	cut(0),
+	havoc(false),
+	decisions()
+{
+}
+
+void CoverageFuzzer::register_engine(ModelChecker *_model, ModelExecution *execution)
+{
+	this->execution = execution;
+}
+
+/**
+ * @brief Decide how this execution uses the corpus
+ *
+ * Called at the first decision of each execution. Of two seeds drawn at
+ * random, the one mutated less often is used.
+ */
+void CoverageFuzzer::start_execution()
+{
+	started = true;
+	unsigned int size = corpus->size();
+	if (size == 0 || model_random() % FRESH_EXECUTION_RATE == 0)
+		return;
+
+	seed = (*corpus)[model_random() % size];
+	struct corpus_seed *other = (*corpus)[model_random() % size];
+	if (other->fuzzed < seed->fuzzed)
+		seed = other;
+	seed->fuzzed++;
+	cut = seed->length == 0 ? 0 : model_random() % seed->length;
+	havoc = model_random() & 1;
+}
+
+/**
+ * @brief Get the seed's value for the next decision
+ * @param avoid Set to a value the decision should not take, or -1
+ * @return The value to take, or -1 to choose at random
+ */
+int CoverageFuzzer::follow(int *avoid)
+{
+	unsigned int i = decisions.size();
+	*avoid = -1;
+	if (!started)
+		start_execution();
+	if (seed == NULL || i >= seed->length)
+		return -1;
+	if (i < cut)
+		return seed->decisions[i];
+	if (i == cut) {
+		*avoid = seed->decisions[i];
+		return -1;
+	}
+	if (havoc && model_random() % HAVOC_RATE != 0)
+		return seed->decisions[i];
+	return -1;
+}
+
+/**
+ * @brief Choose an index in [0, numchoices) for a reads-from or notify
+ * decision, and record it
+ */
+unsigned int CoverageFuzzer::choose(unsigned int numchoices, int planned, int avoid)
+{
+	unsigned int index;
+	if (planned >= 0 && (unsigned int)planned < numchoices)
+		index = planned;
+	else {
+		index = model_random() % numchoices;
+		if (avoid >= 0 && (unsigned int)avoid < numchoices && index == (unsigned int)avoid && numchoices > 1)
+			index = (index + 1 + model_random() % (numchoices - 1)) % numchoices;
+	}
+	decisions.push_back(index);
+	return index;
+}
+
+Thread * CoverageFuzzer::selectThread(ThreadSet * threads)
+{
+	int avoid;
+	int tid = follow(&avoid);
+	if (tid < 0 || !threads->contains(tid)) {
+		int numthreads = threads->size();
+		do {
+			tid = threads->select(model_random() % numthreads);
+		} while (tid == avoid && numthreads > 1);
+	}
+	decisions.push_back(tid);
+	return execution->get_thread(int_to_id(tid));
+}
+
+int CoverageFuzzer::selectWrite(ModelAction *read, scratch_action_vector_t * rf_set)
+{
+	int avoid;
+	int planned = follow(&avoid);
+	return choose(rf_set->size(), planned, avoid);
+}
+
+Thread * CoverageFuzzer::selectNotify(simple_action_list_t * waiters)
+{
+	int avoid;
+	int planned = follow(&avoid);
+	int index = choose(waiters->size(), planned, avoid);
+
+	sllnode<ModelAction*> * it = waiters->begin();
+	while(index--)
+		it = it->getNext();
+	Thread *thread = model->get_thread(it->getVal());
+	waiters->erase(it);
+	return thread;
+}
+
+/**
+ * @return A key for an action's source position and thread. Threads that
+ * run the same code still cover different pairs.
+ */
+static uintptr_t position_key(const ModelAction *act)
+{
+	const char *position = act->get_position();
+	uintptr_t key = position != NULL ? (uintptr_t)position : (uintptr_t)act->get_type();
+	return key ^ ((uintptr_t)id_to_int(act->get_tid()) << 48);
+}
+
+/** @return The bitmap entry for a pair of source positions */
+static unsigned int coverage_index(uintptr_t kind, uintptr_t from, uintptr_t to)
+{
+	uint64_t hash = (from * 0x9E3779B97F4A7C15ULL) ^ (to * 0xC2B2AE3D27D4EB4FULL) ^ kind;
+	hash ^= hash >> 29;
+	hash *= 0xBF58476D1CE4E5B9ULL;
+	hash ^= hash >> 32;
+	return hash & (COVERAGE_MAP_SIZE - 1);
+}
+
+static void record_hit(uint8_t *counts, SnapVector<unsigned int> *touched, unsigned int index)
+{
+	if (counts[index] == 0)
+		touched->push_back(index);
+	if (counts[index] < 255)
+		counts[index]++;
+}
+
+/** @brief AFL's hit-count classes, one bit per class */
+static uint8_t count_class(uint8_t count)
+{
+	if (count <= 3)
+		return 1 << (count - 1);
+	if (count < 8)
+		return 8;
+	if (count < 16)
+		return 16;
+	if (count < 32)
+		return 32;
+	if (count < 128)
+		return 64;
+	return 128;
+}
+
+/**
+ * @brief Hash this execution's coverage into the shared bitmap
+ * @return Whether it hit a bucket no earlier execution hit
+ */
+bool CoverageFuzzer::update_coverage()
+{
+	uint8_t *counts = (uint8_t *)snapshot_calloc(COVERAGE_MAP_SIZE, 1);
+	SnapVector<unsigned int> touched;
+	CycleGraph *mo_graph = execution->get_mo_graph();
+	action_list_t *trace = execution->get_action_trace();
+	const ModelAction *prev = NULL;
+
+	for (sllnode<ModelAction *> *it = trace->begin();it != NULL;it = it->getNext()) {
+		const ModelAction *act = it->getVal();
+
+		/* Reads-from pairs */
+		if (act->is_read() && act->get_reads_from() != NULL)
+			record_hit(counts, &touched, coverage_index(1, position_key(act->get_reads_from()), position_key(act)));
+		/* Thread switches */
+		if (prev != NULL && prev->get_tid() != act->get_tid())
+			record_hit(counts, &touched, coverage_index(2, position_key(prev), position_key(act)));
+		prev = act;
+
+		/* Modification order edges */
+		if (act->is_write()) {
+			CycleNode *node = mo_graph->getNode_noCreate(act);
+			if (node == NULL)
+				continue;
+			for (unsigned int i = 0;i < node->getNumEdges();i++)
+				record_hit(counts, &touched, coverage_index(3, position_key(act), position_key(node->getEdge(i)->getAction())));
+		}
+	}
+
+	bool found = false;
+	for (unsigned int i = 0;i < touched.size();i++) {
+		unsigned int idx = touched[i];
+		uint8_t bucket = count_class(counts[idx]);
+		if (!(virgin[idx] & bucket)) {
+			if (virgin[idx] == 0)
+				(*covered)++;
+			virgin[idx] |= bucket;
+			found = true;
+		}
+	}
+	snapshot_free(counts);
+	return found;
+}
+
+bool CoverageFuzzer::has_more_executions()
+{
+	if (update_coverage())
+		corpus->push_back(new corpus_seed(&decisions));
+	return true;
+}
+
+void CoverageFuzzer::print_stats()
+{
+	model_print("Coverage: %u bitmap entries, %u corpus seeds\n", *covered, corpus->size());
+}
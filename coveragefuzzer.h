@@ -0,0 +1,91 @@
+#ifndef __COVERAGEFUZZER_H__
+#define __COVERAGEFUZZER_H__
+
+#include "fuzzer.h"
+#include "classlist.h"
+#include "mymemory.h"
+#include "stl-model.h"
+#include "config.h"
+
+#define COVERAGE_MAP_SIZE (1 << COVERAGE_MAP_BITS)
+
+/**
+ * @brief A corpus entry: the decisions of an execution that found new
+ * coverage
+ *
+ * Thread decisions are stored as thread ids, reads-from and notify
+ * decisions as indices.
+ */
+struct corpus_seed {
+	corpus_seed(const SnapVector<unsigned int> *decisions);
+	~corpus_seed();
+
+	unsigned int length;
+	unsigned int *decisions;
+
+	/** @brief How many executions have been mutated from this seed */
+	unsigned int fuzzed;
+
+	MEMALLOC
+};
+
+/**
+ * @brief Coverage-guided schedule fuzzing
+ *
+ * At the end of each execution, the reads-from pairs, modification order
+ * edges and thread switches it observed, each as a pair of source
+ * positions, are hashed into a bitmap. As in AFL, an entry's hit count is
+ * bucketed (1, 2, 3, 4-7, 8-15, ...), and an execution that sets a bucket
+ * never seen before adds its decision sequence to the corpus. Both the
+ * bitmap of seen buckets and the corpus live across executions.
+ *
+ * Most executions then mutate a corpus seed: they replay its decisions up
+ * to a random point and either choose differently there and at random
+ * afterwards, or keep following the seed but redraw an occasional decision.
+ * The rest, and every execution until the corpus has a seed, choose at
+ * random.
+ */
+class CoverageFuzzer : public Fuzzer {
+public:
+	CoverageFuzzer();
+	int selectWrite(ModelAction *read, scratch_action_vector_t * rf_set);
+	Thread * selectThread(ThreadSet * threads);
+	Thread * selectNotify(simple_action_list_t * waiters);
+	bool has_more_executions();
+	void print_stats();
+	void register_engine(ModelChecker * model, ModelExecution * execution);
+
+	SNAPSHOTALLOC
+private:
+	void start_execution();
+	int follow(int *avoid);
+	unsigned int choose(unsigned int numchoices, int planned, int avoid);
+	bool update_coverage();
+
+	ModelExecution * execution;
+
+	/** @brief Hit-count buckets seen in any execution, per bitmap entry */
+	uint8_t *virgin;
+
+	/** @brief The corpus, shared by all executions */
+	ModelVector<struct corpus_seed *> * corpus;
+
+	/** @brief Number of bitmap entries with at least one bucket seen */
+	unsigned int *covered;
+
+	bool started;
+
+	/** @brief The seed this execution mutates, or NULL */
+	struct corpus_seed *seed;
+
+	/** @brief The first decision at which the mutant leaves the seed */
+	unsigned int cut;
+
+	/** @brief Whether to keep following the seed after the cut */
+	bool havoc;
+
+	/** @brief This execution's decisions so far */
+	SnapVector<unsigned int> decisions;
+};
+
+#endif	/* __COVERAGEFUZZER_H__ */
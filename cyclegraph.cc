@@ -292,6 +292,8 @@ bool CycleGraph::checkReachable(const ModelAction *from, const ModelAction *to)
 
 void CycleGraph::freeAction(const ModelAction * act) {
 	CycleNode *cn = actionToNode.remove(act);
+	if (cn == NULL)
+		return;
 	for(unsigned int i=0;i<cn->edges.size();i++) {
 		CycleNode *dst = cn->edges[i];
 		dst->removeInEdge(cn);
@@ -73,7 +73,7 @@ public:
 	void removeEdge(CycleNode *dst);
 	~CycleNode();
 
-	SNAPSHOTALLOC
+	SNAPSHOTSLABALLOC(CycleNode)
 private:
 	/** @brief The ModelAction that this node represents */
 	ModelAction *action;
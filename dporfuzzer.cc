@@ -0,0 +1,361 @@
+#include "dporfuzzer.h"
+#include <stdlib.h>
+#include "prng.h"
+#include "threads-model.h"
+#include "model.h"
+#include "execution.h"
+#include "action.h"
+#include "hashtable.h"
+
+DPORFuzzer::DPORFuzzer(int preemptionbound, unsigned int depthbound) :
+	execution(NULL),
+	preemptionbound(preemptionbound),
+	depthbound(depthbound),
+	stack(new ModelVector<explore_decision *>()),
+	position(0),
+	last_tid(-1),
+	preemptions(0),
+	horizon(0),
+	thread_decisions(),
+	last_write_decision(NULL),
+	last_write_position(0),
+	last_read_seq(0),
+	last_writes()
+{
+}
+
+void DPORFuzzer::register_engine(ModelChecker *_model, ModelExecution *execution)
+{
+	this->execution = execution;
+}
+
+/** @brief Drop the search stack's entries from index size on */
+void DPORFuzzer::truncate(unsigned int size)
+{
+	while (stack->size() > size) {
+		delete stack->back();
+		stack->pop_back();
+	}
+}
+
+/**
+ * @brief Get the recorded decision at the current position
+ *
+ * Every execution replays the same prefix, so the decision should have the
+ * same type and number of choices as when it was recorded. If it does not,
+ * the program is not deterministic under a fixed schedule (e.g., it reads
+ * the clock); the rest of the stack no longer describes this execution and
+ * is dropped.
+ * @return The recorded decision, or NULL if this is a new decision
+ */
+explore_decision * DPORFuzzer::replay_decision(decision_type type, unsigned int numchoices)
+{
+	if (position >= stack->size())
+		return NULL;
+	explore_decision *d = (*stack)[position];
+	if (d->type == type && d->numchoices == numchoices) {
+		d->execution = model->get_execution_number();
+		return d;
+	}
+	diverge();
+	return NULL;
+}
+
+/** @brief Drop the rest of a stack that this execution does not follow */
+void DPORFuzzer::diverge()
+{
+	model_print("DPOR: execution %d diverged from its recorded prefix at decision %u\n",
+							model->get_execution_number(), position);
+	truncate(position);
+}
+
+void DPORFuzzer::push_decision(explore_decision *d)
+{
+	ASSERT(position == stack->size());
+	d->execution = model->get_execution_number();
+	stack->push_back(d);
+}
+
+Thread * DPORFuzzer::selectThread(ThreadSet * threads)
+{
+	bool lastenabled = last_tid >= 0 && threads->contains(last_tid);
+	int tid;
+
+	if (position >= depthbound) {
+		if (horizon == 0)
+			horizon = execution->get_curr_seq_num() + 1;
+		tid = id_to_int(Fuzzer::selectThread(threads)->get_id());
+	} else {
+		explore_decision *d = replay_decision(DECISION_THREAD, threads->size());
+		if (d != NULL) {
+			for (unsigned int i = 0;i < d->threads.size();i++) {
+				if (!threads->contains(d->threads[i])) {
+					diverge();
+					d = NULL;
+					break;
+				}
+			}
+		}
+		if (d == NULL) {
+			d = new explore_decision(DECISION_THREAD, threads->size());
+			/* The running thread goes first, so that choice 0 never preempts */
+			if (lastenabled)
+				d->threads.push_back(last_tid);
+			bool canpreempt = preemptionbound < 0 || preemptions < (unsigned int)preemptionbound;
+			if (!lastenabled || canpreempt) {
+				for (int i = threads->next(0);i >= 0;i = threads->next(i + 1))
+					if (i != last_tid || !lastenabled)
+						d->threads.push_back(i);
+			}
+			d->backtrack.resize(d->threads.size());
+			d->backtrack[0] = BACKTRACK_TODO;
+			d->seq = execution->get_curr_seq_num() + 1;
+			push_decision(d);
+		}
+		thread_decisions.push_back(position);
+		position++;
+		tid = d->threads[d->choice];
+	}
+
+	if (lastenabled && tid != last_tid)
+		preemptions++;
+	last_tid = tid;
+	return execution->get_thread(int_to_id(tid));
+}
+
+int DPORFuzzer::selectWrite(ModelAction *read, scratch_action_vector_t * rf_set)
+{
+	if (read->get_seq_number() == last_read_seq) {
+		/* The last choice broke modification order and was removed from
+		 * rf_set. Which writes are feasible depends only on the prefix, so
+		 * skip to the next alternative for good. */
+		if (last_write_decision == NULL)
+			return Fuzzer::selectWrite(read, rf_set);
+		explore_decision *d = last_write_decision;
+		if (d->choice + 1 < d->numchoices) {
+			d->choice++;
+			truncate(last_write_position + 1);
+		}
+		ModelAction *rf = last_writes[d->choice];
+		for (unsigned int i = 0;i < rf_set->size();i++)
+			if ((*rf_set)[i] == rf)
+				return i;
+		/* Every later alternative was infeasible; this execution repeats
+		 * an earlier one */
+		return Fuzzer::selectWrite(read, rf_set);
+	}
+
+	last_read_seq = read->get_seq_number();
+	last_write_decision = NULL;
+	if (position >= depthbound)
+		return Fuzzer::selectWrite(read, rf_set);
+
+	explore_decision *d = replay_decision(DECISION_WRITE, rf_set->size());
+	if (d == NULL) {
+		d = new explore_decision(DECISION_WRITE, rf_set->size());
+		push_decision(d);
+	}
+	last_write_decision = d;
+	last_write_position = position++;
+	last_writes.clear();
+	for (unsigned int i = 0;i < rf_set->size();i++)
+		last_writes.push_back((*rf_set)[i]);
+	return d->choice;
+}
+
+Thread * DPORFuzzer::selectNotify(simple_action_list_t * waiters)
+{
+	int index;
+	if (position >= depthbound) {
+		index = model_random() % waiters->size();
+	} else {
+		explore_decision *d = replay_decision(DECISION_NOTIFY, waiters->size());
+		if (d == NULL) {
+			d = new explore_decision(DECISION_NOTIFY, waiters->size());
+			push_decision(d);
+		}
+		position++;
+		index = d->choice;
+	}
+
+	sllnode<ModelAction*> * it = waiters->begin();
+	while(index--)
+		it = it->getNext();
+	Thread *thread = model->get_thread(it->getVal());
+	waiters->erase(it);
+	return thread;
+}
+
+bool DPORFuzzer::shouldWait(const ModelAction *wait)
+{
+	if (!wait->is_timed())
+		return true;
+	if (position >= depthbound)
+		return model_random() & 1;
+
+	/* Choice 0 waits, choice 1 times out right away */
+	explore_decision *d = replay_decision(DECISION_WAIT, 2);
+	if (d == NULL) {
+		d = new explore_decision(DECISION_WAIT, 2);
+		push_decision(d);
+	}
+	position++;
+	return d->choice == 0;
+}
+
+/** @return Whether an action takes part in races */
+static bool is_racing_access(const ModelAction *act)
+{
+	return act->is_read() || act->is_write() || act->is_mutex_op();
+}
+
+/**
+ * @return Whether two accesses to the same location do not commute. An
+ * unlock only enables the next lock; the race is between the locks.
+ */
+static bool is_dependent(const ModelAction *a, const ModelAction *b)
+{
+	if (a->is_mutex_op() || b->is_mutex_op())
+		return !a->is_unlock() && !b->is_unlock();
+	return a->is_write() || b->is_write();
+}
+
+/**
+ * @brief Find this execution's races and extend the backtrack sets
+ *
+ * For each access, the latest earlier access by another thread to the same
+ * location that it depends on and that did not happen before the access's
+ * thread reached it is a race.
+ */
+void DPORFuzzer::add_backtracks()
+{
+	HashTable<const void *, SnapVector<ModelAction *> *, uintptr_t, 2> accesses;
+	/* Each thread's latest action so far */
+	SnapVector<ModelAction *> thrd_last;
+	action_list_t *trace = execution->get_action_trace();
+
+	for (sllnode<ModelAction *> *it = trace->begin();it != NULL;it = it->getNext()) {
+		ModelAction *act = it->getVal();
+		if (act->get_cv() == NULL)
+			continue;
+		int tid = id_to_int(act->get_tid());
+		if ((unsigned int)tid >= thrd_last.size())
+			thrd_last.resize(tid + 1);
+		ModelAction *before = thrd_last[tid];
+		thrd_last[tid] = act;
+		if (!is_racing_access(act))
+			continue;
+		SnapVector<ModelAction *> *list = accesses.get(act->get_location());
+		if (list == NULL) {
+			list = new SnapVector<ModelAction *>();
+			accesses.put(act->get_location(), list);
+		}
+		for (int i = (int)list->size() - 1;i >= 0;i--) {
+			ModelAction *prev = (*list)[i];
+			if (prev->get_tid() == act->get_tid() || !is_dependent(prev, act))
+				continue;
+			/* Reading from prev synchronizes with it, so what counts is
+			 * whether prev happened before act's thread got here */
+			if (before == NULL || !prev->happens_before(before)) {
+				add_backtrack(prev, act);
+				break;
+			}
+		}
+		/* Only actions before the depth bound can be reordered */
+		if (horizon == 0 || act->get_seq_number() < horizon)
+			list->push_back(act);
+	}
+}
+
+/**
+ * @brief Schedule second's thread before first in a later execution
+ *
+ * The point to do so is the last thread decision at or before first. If
+ * second's thread was not enabled there, every candidate is tried.
+ */
+void DPORFuzzer::add_backtrack(const ModelAction *first, const ModelAction *second)
+{
+	/* Binary search for the last thread decision with seq <= first's */
+	int lo = 0, hi = (int)thread_decisions.size() - 1, found = -1;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		if ((*stack)[thread_decisions[mid]]->seq <= first->get_seq_number()) {
+			found = mid;
+			lo = mid + 1;
+		} else
+			hi = mid - 1;
+	}
+	if (found < 0)
+		return;
+
+	explore_decision *d = (*stack)[thread_decisions[found]];
+	int tid = id_to_int(second->get_tid());
+	for (unsigned int i = 0;i < d->threads.size();i++) {
+		if (d->threads[i] == tid) {
+			if (d->backtrack[i] == BACKTRACK_NONE)
+				d->backtrack[i] = BACKTRACK_TODO;
+			return;
+		}
+	}
+	for (unsigned int i = 0;i < d->threads.size();i++)
+		if (d->backtrack[i] == BACKTRACK_NONE)
+			d->backtrack[i] = BACKTRACK_TODO;
+}
+
+/**
+ * @brief Move the search to the next unexplored execution
+ * @return False once the search space within the bounds is exhausted
+ */
+bool DPORFuzzer::has_more_executions()
+{
+	/* Recorded decisions this execution never reached are stale */
+	truncate(position);
+	add_backtracks();
+	return backtrack();
+}
+
+/**
+ * @brief Move past the choice that crashed
+ *
+ * Runs in the parent process, which has neither the dead execution's
+ * position nor its trace. The decisions it reached carry its number; the
+ * last of them moves on to its next alternative, or is backtracked. No
+ * races are added, as the trace is gone.
+ * @return False once the search space within the bounds is exhausted
+ */
+bool DPORFuzzer::execution_crashed()
+{
+	int number = model->get_execution_number();
+	unsigned int reached = 0;
+	while (reached < stack->size() && (*stack)[reached]->execution == number)
+		reached++;
+	truncate(reached);
+	return backtrack();
+}
+
+/**
+ * @brief Mark the deepest decision's choice explored and go to the next
+ * alternative, popping decisions that have none left
+ * @return False once the stack is empty
+ */
+bool DPORFuzzer::backtrack()
+{
+	while (!stack->empty()) {
+		explore_decision *d = stack->back();
+		if (d->type == DECISION_THREAD) {
+			d->backtrack[d->choice] = BACKTRACK_DONE;
+			for (unsigned int i = 0;i < d->threads.size();i++) {
+				if (d->backtrack[i] == BACKTRACK_TODO) {
+					d->choice = i;
+					return true;
+				}
+			}
+		} else if (d->choice + 1 < d->numchoices) {
+			d->choice++;
+			return true;
+		}
+		delete d;
+		stack->pop_back();
+	}
+	return false;
+}
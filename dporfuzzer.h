@@ -0,0 +1,132 @@
+#ifndef __DPORFUZZER_H__
+#define __DPORFUZZER_H__
+
+#include "fuzzer.h"
+#include "classlist.h"
+#include "mymemory.h"
+#include "stl-model.h"
+
+/** @brief The kinds of choices the DPOR fuzzer enumerates */
+enum decision_type {
+	DECISION_THREAD,
+	DECISION_WRITE,
+	DECISION_NOTIFY,
+	DECISION_WAIT
+};
+
+/** @brief States of one alternative of a thread decision */
+enum backtrack_state {
+	BACKTRACK_NONE,
+	BACKTRACK_TODO,
+	BACKTRACK_DONE
+};
+
+/**
+ * @brief One decision point on the depth-first search stack
+ *
+ * Lives in the non-snapshotting heap, so that it survives the end of the
+ * execution that recorded it.
+ */
+struct explore_decision {
+	explore_decision(decision_type type, unsigned int numchoices) :
+		type(type),
+		numchoices(numchoices),
+		choice(0),
+		threads(),
+		backtrack(),
+		seq(0),
+		execution(0)
+	{ }
+
+	decision_type type;
+
+	/** @brief Number of enabled threads, writes, waiters or wait outcomes to choose from */
+	unsigned int numchoices;
+
+	/** @brief The alternative being explored */
+	unsigned int choice;
+
+	/** @brief Thread decisions: the candidate threads, in exploration order */
+	ModelVector<int> threads;
+
+	/** @brief Thread decisions: backtrack_state of each candidate */
+	ModelVector<char> backtrack;
+
+	/** @brief Thread decisions: sequence number of the step they scheduled */
+	modelclock_t seq;
+
+	/** @brief Number of the last execution that reached this decision */
+	int execution;
+
+	MEMALLOC
+};
+
+/**
+ * @brief Bounded systematic exploration with dynamic partial-order reduction
+ *
+ * Every scheduling, reads-from and notify choice within the first
+ * depthbound decisions is a node of a depth-first search whose stack lives
+ * across executions. Each execution replays the stack's choices from the
+ * initial snapshot and then takes the first alternative of every new
+ * decision. At the end of the execution, each pair of racing actions (same
+ * location, at least one write, not ordered by happens-before) adds the
+ * later action's thread to the backtrack set of the scheduling decision
+ * that ran the earlier one, so thread orders that only swap independent
+ * actions are not explored. Reads-from and notify alternatives, and whether
+ * each timed wait blocks or times out, are all explored.
+ *
+ * A thread decision that would preempt the running thread is not taken once
+ * the preemption bound is spent. Decisions past the depth bound are random.
+ */
+class DPORFuzzer : public Fuzzer {
+public:
+	DPORFuzzer(int preemptionbound, unsigned int depthbound);
+	int selectWrite(ModelAction *read, scratch_action_vector_t * rf_set);
+	Thread * selectThread(ThreadSet * threads);
+	Thread * selectNotify(simple_action_list_t * waiters);
+	bool shouldWait(const ModelAction *wait);
+	bool has_more_executions();
+	bool execution_crashed();
+	void register_engine(ModelChecker * model, ModelExecution * execution);
+
+	SNAPSHOTALLOC
+private:
+	explore_decision * replay_decision(decision_type type, unsigned int numchoices);
+	void diverge();
+	void push_decision(explore_decision *d);
+	void truncate(unsigned int size);
+	bool backtrack();
+	void add_backtracks();
+	void add_backtrack(const ModelAction *first, const ModelAction *second);
+
+	ModelExecution * execution;
+	int preemptionbound;
+	unsigned int depthbound;
+
+	/** @brief The search stack, shared by all executions */
+	ModelVector<explore_decision *> * stack;
+
+	/** @brief Index of this execution's next decision */
+	unsigned int position;
+
+	/** @brief Thread picked by the last thread decision */
+	int last_tid;
+
+	unsigned int preemptions;
+
+	/** @brief Actions with this sequence number or later ran past the depth bound */
+	modelclock_t horizon;
+
+	/** @brief Positions of this execution's thread decisions */
+	SnapVector<unsigned int> thread_decisions;
+
+	/** @brief The last write decision, in case its choice cannot be read */
+	explore_decision * last_write_decision;
+	unsigned int last_write_position;
+	modelclock_t last_read_seq;
+
+	/** @brief The writes offered to the last write decision, in order */
+	SnapVector<ModelAction *> last_writes;
+};
+
+#endif	/* __DPORFUZZER_H__ */
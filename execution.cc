@@ -2,6 +2,8 @@
 #include <algorithm>
 #include <new>
 #include <stdarg.h>
+#include <errno.h>
+#include <time.h>
 
 #include "model.h"
 #include "execution.h"
@@ -41,8 +43,11 @@ struct model_snapshot_members {
 		/* First thread created will have id INITIAL_THREAD_ID */
 		next_thread_id(INITIAL_THREAD_ID),
 		used_sequence_numbers(0),
+		virtual_time(0),
+		spin_loops(0),
 		bugs(),
-		asserted(false)
+		asserted(false),
+		truncated(false)
 	{ }
 
 	~model_snapshot_members() {
@@ -53,9 +58,15 @@ struct model_snapshot_members {
 
 	unsigned int next_thread_id;
 	modelclock_t used_sequence_numbers;
+	/** @brief Nanoseconds since the execution started, on its virtual clock */
+	uint64_t virtual_time;
+	/** @brief Number of times a thread was found spinning */
+	unsigned int spin_loops;
 	SnapVector<bug_message *> bugs;
 	/** @brief Incorrectly-ordered synchronization was made */
 	bool asserted;
+	/** @brief The execution ran out of its action or time budget */
+	bool truncated;
 
 	SNAPSHOTALLOC
 };
@@ -69,15 +80,15 @@ ModelExecution::ModelExecution(ModelChecker *m, Scheduler *scheduler) :
 	pthread_map(0),
 	pthread_counter(2),
 	action_trace(),
-	obj_map(),
-	condvar_waiters_map(),
-	obj_thrd_map(),
-	obj_wr_thrd_map(),
-	obj_last_sc_map(),
+	obj_state(),
+	loc_cache(),
+	thrd_spin(),
+	thrd_hash(),
 	mutex_map(),
 	cond_map(),
 	thrd_last_action(1),
 	thrd_last_fence_release(),
+	thrd_sc_fences(),
 	priv(new struct model_snapshot_members ()),
 	mo_graph(new CycleGraph()),
 #ifdef NEWFUZZER
@@ -112,36 +123,6 @@ int ModelExecution::get_execution_number() const
 	return model->get_execution_number();
 }
 
-static SnapVector<action_list_t> * get_safe_ptr_vect_action(HashTable<const void *, SnapVector<action_list_t> *, uintptr_t, 2> * hash, void * ptr)
-{
-	SnapVector<action_list_t> *tmp = hash->get(ptr);
-	if (tmp == NULL) {
-		tmp = new SnapVector<action_list_t>();
-		hash->put(ptr, tmp);
-	}
-	return tmp;
-}
-
-static simple_action_list_t * get_safe_ptr_action(HashTable<const void *, simple_action_list_t *, uintptr_t, 2> * hash, void * ptr)
-{
-	simple_action_list_t *tmp = hash->get(ptr);
-	if (tmp == NULL) {
-		tmp = new simple_action_list_t();
-		hash->put(ptr, tmp);
-	}
-	return tmp;
-}
-
-static SnapVector<simple_action_list_t> * get_safe_ptr_vect_action(HashTable<const void *, SnapVector<simple_action_list_t> *, uintptr_t, 2> * hash, void * ptr)
-{
-	SnapVector<simple_action_list_t> *tmp = hash->get(ptr);
-	if (tmp == NULL) {
-		tmp = new SnapVector<simple_action_list_t>();
-		hash->put(ptr, tmp);
-	}
-	return tmp;
-}
-
 /**
  * When vectors of action lists are reallocated due to resize, the root address of
  * action lists may change. Hence we need to fix the parent pointer of the children
@@ -156,6 +137,19 @@ static void fixup_action_list(SnapVector<action_list_t> * vec)
 	}
 }
 
+/**
+ * Raise a sequence number bound to cover an SC fence, if there is one
+ * @param bound The bound so far
+ * @param fence The fence, or NULL
+ * @return The larger of bound and the fence's sequence number
+ */
+static inline modelclock_t fence_bound(modelclock_t bound, const ModelAction *fence)
+{
+	if (fence != NULL && fence->get_seq_number() > bound)
+		return fence->get_seq_number();
+	return bound;
+}
+
 #ifdef COLLECT_STAT
 static inline void record_atomic_stats(ModelAction * act)
 {
@@ -173,6 +167,7 @@ static inline void record_atomic_stats(ModelAction * act)
 		atomic_fence_count++;
 		break;
 	case ATOMIC_LOCK:
+	case ATOMIC_TIMEDLOCK:
 		atomic_lock_count++;
 		break;
 	case ATOMIC_TRYLOCK:
@@ -251,8 +246,8 @@ bool ModelExecution::should_wake_up(const ModelAction *curr, const Thread *threa
 {
 	const ModelAction *asleep = thread->get_pending();
 
-	/* The sleep is literally sleeping */
-	if (asleep->is_sleep()) {
+	/* The thread is sleeping, or waiting with a timeout */
+	if (asleep->is_sleep() || asleep->is_timed()) {
 		if (fuzzer->shouldWake(asleep))
 			return true;
 	}
@@ -260,18 +255,101 @@ bool ModelExecution::should_wake_up(const ModelAction *curr, const Thread *threa
 	return false;
 }
 
+/**
+ * @brief End the sleep, timed lock or timed wait of a thread in the sleep set
+ *
+ * Timed locks and waits report ETIMEDOUT, and a timed wait stops waiting
+ * for a notify.
+ * @param thr The thread to wake up
+ */
+void ModelExecution::wake_up_sleeper(Thread *thr)
+{
+	ModelAction *asleep = thr->get_pending();
+	scheduler->remove_sleep(thr);
+	thr->set_wakeup_state(true);
+	if (!asleep->is_timed())
+		return;
+
+	thr->set_return_value(ETIMEDOUT);
+	if (asleep->is_wait()) {
+		simple_action_list_t * waiters = &get_location_state(asleep->get_tid(), asleep->get_location())->waiters;
+		for (sllnode<ModelAction *> * it = waiters->begin();it != NULL;it = it->getNext()) {
+			if (it->getVal() == asleep) {
+				waiters->erase(it);
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Wake up a thread that a notify took off a waiters list
+ * @param thr The waiting thread
+ */
+void ModelExecution::wake_up_waiter(Thread *thr)
+{
+	/* A timed waiter waits in the sleep set, with its wait pending */
+	if (scheduler->is_sleep_set(thr))
+		thr->set_wakeup_state(true);
+	scheduler->wake(thr);
+}
+
 void ModelExecution::wake_up_sleeping_actions(ModelAction *curr)
 {
 	for (unsigned int i = 0;i < get_num_threads();i++) {
 		thread_id_t tid = int_to_id(i);
 		if (scheduler->is_sleep_set(tid)) {
 			Thread *thr = get_thread(tid);
-			if (should_wake_up(curr, thr)) {
-				/* Remove this thread from sleep set */
-				scheduler->remove_sleep(thr);
-				if (thr->get_pending()->is_sleep())
-					thr->set_wakeup_state(true);
-			}
+			if (should_wake_up(curr, thr))
+				wake_up_sleeper(thr);
+		}
+	}
+}
+
+/** @return The current time on this execution's virtual clock, in nanoseconds */
+uint64_t ModelExecution::get_virtual_time() const
+{
+	return priv->virtual_time;
+}
+
+/**
+ * @brief Convert an absolute CLOCK_REALTIME deadline, as given to a timed
+ * lock or wait, to the virtual clock
+ * @param abstime The deadline
+ * @return The virtual time that is as far away as the deadline is from now
+ */
+uint64_t ModelExecution::get_virtual_deadline(const struct timespec *abstime) const
+{
+	struct timespec currtime;
+	clock_gettime(CLOCK_REALTIME, &currtime);
+	int64_t timeout = (int64_t)(abstime->tv_sec - currtime.tv_sec) * 1000000000 + (abstime->tv_nsec - currtime.tv_nsec);
+	return priv->virtual_time + (timeout > 0 ? timeout : 0);
+}
+
+/**
+ * @brief Wake up the sleeping threads with the earliest deadline
+ *
+ * Called when every runnable thread is sleeping or waiting with a timeout.
+ * Nothing can happen until a deadline passes, so the virtual clock skips
+ * ahead to the first deadline instead of waiting for it.
+ */
+void ModelExecution::skip_to_next_wakeup()
+{
+	uint64_t deadline = UINT64_MAX;
+	for (unsigned int i = 0;i < get_num_threads();i++) {
+		thread_id_t tid = int_to_id(i);
+		if (scheduler->is_sleep_set(tid))
+			deadline = std::min(deadline, get_thread(tid)->get_pending()->get_wakeup_time());
+	}
+	if (deadline > priv->virtual_time)
+		priv->virtual_time = deadline;
+
+	for (unsigned int i = 0;i < get_num_threads();i++) {
+		thread_id_t tid = int_to_id(i);
+		if (scheduler->is_sleep_set(tid)) {
+			Thread *thr = get_thread(tid);
+			if (thr->get_pending()->get_wakeup_time() <= priv->virtual_time)
+				wake_up_sleeper(thr);
 		}
 	}
 }
@@ -314,6 +392,18 @@ void ModelExecution::set_assert()
 	priv->asserted = true;
 }
 
+/** @brief End this execution early, without checking it for bugs */
+void ModelExecution::set_truncated()
+{
+	priv->truncated = true;
+}
+
+/** @return True if this execution was cut short by its budget */
+bool ModelExecution::is_truncated() const
+{
+	return priv->truncated;
+}
+
 /**
  * Check if we are in a deadlock. Should only be called at the end of an
  * execution, although it should not give false positives in the middle of an
@@ -373,9 +463,9 @@ ModelAction * ModelExecution::convertNonAtomicStore(void * location) {
  * @param rf_set is the set of model actions we can possibly read from
  * @return True if the read can be pruned from the thread map list.
  */
-bool ModelExecution::process_read(ModelAction *curr, SnapVector<ModelAction *> * rf_set)
+bool ModelExecution::process_read(ModelAction *curr, scratch_action_vector_t * rf_set)
 {
-	SnapVector<ModelAction *> * priorset = new SnapVector<ModelAction *>();
+	scratch_action_vector_t * priorset = new scratch_action_vector_t();
 	bool hasnonatomicstore = hasNonAtomicStore(curr->get_location());
 	if (hasnonatomicstore) {
 		ModelAction * nonatomicstore = convertNonAtomicStore(curr->get_location());
@@ -455,11 +545,16 @@ bool ModelExecution::process_mutex(ModelAction *curr)
 		get_thread(curr)->set_return_value(1);
 	}
 	//otherwise fall into the lock case
+	case ATOMIC_TIMEDLOCK:
 	case ATOMIC_LOCK: {
 		//TODO: FIND SOME BETTER WAY TO CHECK LOCK INITIALIZED OR NOT
 		//if (curr->get_cv()->getClock(state->alloc_tid) <= state->alloc_clock)
 		//	assert_bug("Lock access before initialization");
 
+		/* A timed lock that runs got the lock before its deadline */
+		if (curr->is_timed())
+			get_thread(curr)->set_return_value(0);
+
 		// TODO: lock count for recursive mutexes
 		state->locked = get_thread(curr);
 		ModelAction *unlock = get_last_unlock(curr);
@@ -485,7 +580,7 @@ bool ModelExecution::process_mutex(ModelAction *curr)
 			state->locked = NULL;
 
 			/* remove old wait action and disable this thread */
-			simple_action_list_t * waiters = get_safe_ptr_action(&condvar_waiters_map, curr->get_location());
+			simple_action_list_t * waiters = &get_location_state(curr->get_tid(), curr->get_location())->waiters;
 			for (sllnode<ModelAction *> * it = waiters->begin();it != NULL;it = it->getNext()) {
 				ModelAction * wait = it->getVal();
 				if (wait->get_tid() == curr->get_tid()) {
@@ -500,7 +595,40 @@ bool ModelExecution::process_mutex(ModelAction *curr)
 
 		break;
 	}
-	case ATOMIC_TIMEDWAIT:
+	case ATOMIC_TIMEDWAIT: {
+		Thread *curr_thrd = get_thread(curr);
+		/* wake up the other threads */
+		for (unsigned int i = 0;i < get_num_threads();i++) {
+			Thread *t = get_thread(int_to_id(i));
+			if (t->waiting_on() == curr_thrd && t->get_pending()->is_lock())
+				scheduler->wake(t);
+		}
+
+		/* unlock the lock - after checking who was waiting on it */
+		state->locked = NULL;
+
+		if (fuzzer->shouldWait(curr)) {
+			/* Wait for a notify, like a normal wait, but in the sleep set
+			 * until the deadline passes */
+			simple_action_list_t * waiters = &get_location_state(curr->get_tid(), curr->get_location())->waiters;
+			for (sllnode<ModelAction *> * it = waiters->begin();it != NULL;it = it->getNext()) {
+				if (it->getVal()->get_tid() == curr->get_tid()) {
+					waiters->erase(it);
+					break;
+				}
+			}
+			waiters->push_back(curr);
+			curr_thrd->set_return_value(0);
+			curr_thrd->set_pending(curr);
+			scheduler->add_sleep(curr_thrd);
+		} else {
+			/* Time out without waiting: the clock moves on to the deadline */
+			if (curr->get_wakeup_time() > priv->virtual_time)
+				priv->virtual_time = curr->get_wakeup_time();
+			curr_thrd->set_return_value(ETIMEDOUT);
+		}
+		break;
+	}
 	case ATOMIC_UNLOCK: {
 		//TODO: FIX WAIT SITUATION...WAITS CAN SPURIOUSLY
 		//FAIL...TIMED WAITS SHOULD PROBABLY JUST BE THE SAME
@@ -525,19 +653,19 @@ bool ModelExecution::process_mutex(ModelAction *curr)
 		break;
 	}
 	case ATOMIC_NOTIFY_ALL: {
-		simple_action_list_t *waiters = get_safe_ptr_action(&condvar_waiters_map, curr->get_location());
+		simple_action_list_t *waiters = &get_location_state(curr->get_tid(), curr->get_location())->waiters;
 		//activate all the waiting threads
 		for (sllnode<ModelAction *> * rit = waiters->begin();rit != NULL;rit=rit->getNext()) {
-			scheduler->wake(get_thread(rit->getVal()));
+			wake_up_waiter(get_thread(rit->getVal()));
 		}
 		waiters->clear();
 		break;
 	}
 	case ATOMIC_NOTIFY_ONE: {
-		simple_action_list_t *waiters = get_safe_ptr_action(&condvar_waiters_map, curr->get_location());
+		simple_action_list_t *waiters = &get_location_state(curr->get_tid(), curr->get_location())->waiters;
 		if (waiters->size() != 0) {
 			Thread * thread = fuzzer->selectNotify(waiters);
-			scheduler->wake(thread);
+			wake_up_waiter(thread);
 		}
 		break;
 	}
@@ -757,6 +885,7 @@ bool ModelExecution::synchronize(const ModelAction *first, ModelAction *second)
  */
 bool ModelExecution::check_action_enabled(ModelAction *curr) {
 	switch (curr->get_type()) {
+	case ATOMIC_TIMEDLOCK:
 	case ATOMIC_LOCK: {
 		cdsc::mutex *lock = curr->get_mutex();
 		struct cdsc::mutex_state *state = lock->get_state();
@@ -809,15 +938,24 @@ ModelAction * ModelExecution::check_current_action(ModelAction *curr)
 
 	DBG();
 
+	priv->virtual_time += VIRTUAL_TIME_PER_ACTION;
 	wake_up_sleeping_actions(curr);
 
-	SnapVector<ModelAction *> * rf_set = NULL;
+	bool isprivate = false;
+	if (newly_explored && (curr->is_read() || curr->is_write()))
+		isprivate = check_private_access(curr);
+
+	scratch_action_vector_t * rf_set = NULL;
 	bool canprune = false;
 	/* Build may_read_from set for newly-created actions */
 	if (curr->is_read() && newly_explored) {
-		rf_set = build_may_read_from(curr);
-		canprune = process_read(curr, rf_set);
-		delete rf_set;
+		if (isprivate) {
+			process_private_read(curr);
+		} else {
+			rf_set = build_may_read_from(curr);
+			canprune = process_read(curr, rf_set);
+			delete rf_set;
+		}
 	} else
 		ASSERT(rf_set == NULL);
 
@@ -843,14 +981,148 @@ ModelAction * ModelExecution::check_current_action(ModelAction *curr)
 	if (curr->is_mutex_op())
 		process_mutex(curr);
 
+	check_spinning(curr);
+	hash_action(curr);
+
 	return curr;
 }
 
+/**
+ * @brief Track runs of identical reads, and deprioritize threads that spin
+ *
+ * A thread that reads the same value at the same position from the same
+ * location SPIN_THRESHOLD times in a row, with no write to the location in
+ * between, is spinning: it can't make progress until someone writes the
+ * location. It only runs when no other thread can, until a write to the
+ * location comes along, or until the thread itself does anything else:
+ * another read, a write, or any other action but a fence or yield.
+ *
+ * @param curr The action just processed
+ */
+void ModelExecution::check_spinning(ModelAction *curr)
+{
+	int tid = id_to_int(curr->get_tid());
+	if ((int)thrd_spin.size() <= tid)
+		thrd_spin.resize(get_num_threads());
+	struct spin_state *spin = &thrd_spin[tid];
+
+	/* The read half of an RMW counts once it turns out to be a plain read;
+	 * fences and yields are part of many spin loops */
+	if (curr->is_rmwr() || curr->is_fence() || curr->get_type() == THREAD_YIELD)
+		return;
+
+	if (curr->is_read()) {
+		LocationState *state = get_location_state(curr->get_tid(), curr->get_location());
+		uint64_t value = curr->get_reads_from_value();
+		if (spin->count != 0 && spin->position == curr->get_position() &&
+				spin->location == curr->get_location() && spin->value == value &&
+				spin->num_writes == state->num_writes) {
+			if (spin->count < SPIN_THRESHOLD && ++spin->count == SPIN_THRESHOLD) {
+				Thread *thr = get_thread(curr);
+				if (scheduler->get_enabled(thr) == THREAD_ENABLED) {
+					priv->spin_loops++;
+					scheduler->add_spinning(thr);
+				}
+			}
+			return;
+		}
+		/* A different read starts a new run */
+		spin->position = curr->get_position();
+		spin->location = curr->get_location();
+		spin->value = value;
+		spin->num_writes = state->num_writes;
+		spin->count = 1;
+	} else
+		spin->count = 0;
+
+	/* The thread left the loop, e.g. by reading a newer value it could
+	 * already have read */
+	if (scheduler->is_spinning(curr->get_tid()))
+		scheduler->remove_spinning(get_thread(curr));
+	if (curr->is_write())
+		wake_up_spinners(curr);
+}
+
+/** @brief Let the threads spinning on a location run normally again */
+void ModelExecution::wake_up_spinners(const ModelAction *write)
+{
+	get_location_state(write->get_tid(), write->get_location())->num_writes++;
+	if (scheduler->num_spinning() == 0)
+		return;
+	for (unsigned int i = 0;i < thrd_spin.size();i++) {
+		thread_id_t tid = int_to_id(i);
+		if (scheduler->is_spinning(tid) && thrd_spin[i].location == write->get_location())
+			scheduler->remove_spinning(get_thread(tid));
+	}
+}
+
+/** @return The number of times a thread was found spinning in this execution */
+unsigned int ModelExecution::get_num_spin_loops() const
+{
+	return priv->spin_loops;
+}
+
+/** @brief Mix a word into a running hash */
+static inline uint64_t hash_combine(uint64_t hash, uint64_t value)
+{
+	hash = (hash ^ value) * 0x9E3779B97F4A7C15ULL;
+	return hash ^ (hash >> 32);
+}
+
+/**
+ * @brief Fold an action into its thread's running hash
+ *
+ * Each action contributes its type and source position, and the value it
+ * read or wrote. A read also contributes the thread and source position of
+ * the write it read from. Pointers into the model checker's own state are
+ * left out, as they differ from one execution to the next.
+ *
+ * @param curr The action just processed
+ */
+void ModelExecution::hash_action(const ModelAction *curr)
+{
+	int tid = id_to_int(curr->get_tid());
+	if ((int)thrd_hash.size() <= tid)
+		thrd_hash.resize(get_num_threads());
+	uint64_t hash = thrd_hash[tid];
+
+	hash = hash_combine(hash, curr->get_type());
+	hash = hash_combine(hash, (uintptr_t)curr->get_position());
+	if (curr->is_read()) {
+		const ModelAction *rf = curr->get_reads_from();
+		if (rf != NULL) {
+			hash = hash_combine(hash, id_to_int(rf->get_tid()));
+			hash = hash_combine(hash, (uintptr_t)rf->get_position());
+		}
+		hash = hash_combine(hash, curr->get_reads_from_value());
+	}
+	if (curr->is_write())
+		hash = hash_combine(hash, curr->get_write_value());
+
+	thrd_hash[tid] = hash;
+}
+
+/**
+ * @brief Get a hash of what this execution did
+ *
+ * Combines each thread's running hash. Two executions that differ only in
+ * how the actions of different threads interleave, but in which every
+ * thread ran the same actions and read from the same writes, hash the
+ * same.
+ */
+uint64_t ModelExecution::get_trace_hash() const
+{
+	uint64_t hash = 0;
+	for (unsigned int i = 0;i < thrd_hash.size();i++)
+		hash = hash_combine(hash, thrd_hash[i]);
+	return hash;
+}
+
 /** Close out a RMWR by converting previous RMWR into a RMW or READ. */
 ModelAction * ModelExecution::process_rmw(ModelAction *act) {
 	ModelAction *lastread = get_last_action(act->get_tid());
 	lastread->process_rmw(act);
-	if (act->is_rmw()) {
+	if (act->is_rmw() && !is_private_location(lastread)) {
 		mo_graph->addRMWEdge(lastread->get_reads_from(), lastread);
 	}
 	return lastread;
@@ -877,9 +1149,9 @@ ModelAction * ModelExecution::process_rmw(ModelAction *act) {
  */
 
 bool ModelExecution::r_modification_order(ModelAction *curr, const ModelAction *rf,
-																					SnapVector<ModelAction *> * priorset, bool * canprune)
+																					scratch_action_vector_t * priorset, bool * canprune)
 {
-	SnapVector<action_list_t> *thrd_lists = obj_thrd_map.get(curr->get_location());
+	SnapVector<action_list_t> *thrd_lists = &get_location_state(curr->get_tid(), curr->get_location())->thrd_actions;
 	ASSERT(curr->is_read());
 
 	/* Last SC fence in the current thread */
@@ -917,10 +1189,18 @@ bool ModelExecution::r_modification_order(ModelAction *curr, const ModelAction *
 			continue;
 		}
 
+		/* Later actions can neither happen before curr nor be ordered
+		 * before it by an SC fence, so start the search below this bound */
+		modelclock_t bound = curr->get_cv()->getClock(int_to_id(tid));
+		if (curr->is_seqcst())
+			bound = fence_bound(bound, last_sc_fence_thread_local);
+		bound = fence_bound(bound, last_sc_fence_local);
+		bound = fence_bound(bound, last_sc_fence_thread_before);
+
 		/* Iterate over actions in thread, starting from most recent */
 		action_list_t *list = &(*thrd_lists)[tid];
 		sllnode<ModelAction *> * rit;
-		for (rit = list->end();rit != NULL;rit=rit->getPrev()) {
+		for (rit = list->findLast(bound);rit != NULL;rit=rit->getPrev()) {
 			ModelAction *act = rit->getVal();
 
 			/* Skip curr */
@@ -1022,21 +1302,29 @@ bool ModelExecution::r_modification_order(ModelAction *curr, const ModelAction *
  */
 void ModelExecution::w_modification_order(ModelAction *curr)
 {
-	SnapVector<action_list_t> *thrd_lists = obj_thrd_map.get(curr->get_location());
+	LocationState *state = get_location_state(curr->get_tid(), curr->get_location());
+	SnapVector<action_list_t> *thrd_lists = &state->thrd_actions;
 	unsigned int i;
 	ASSERT(curr->is_write());
 
+	if (!state->shared) {
+		/* Program order already orders the writes to a private location */
+		if (curr->is_seqcst())
+			state->last_sc_write = curr;
+		return;
+	}
+
 	SnapList<ModelAction *> edgeset;
 
 	if (curr->is_seqcst()) {
 		/* We have to at least see the last sequentially consistent write,
 		         so we are initialized. */
-		ModelAction *last_seq_cst = get_last_seq_cst_write(curr);
+		ModelAction *last_seq_cst = state->last_sc_write;
 		if (last_seq_cst != NULL) {
 			edgeset.push_back(last_seq_cst);
 		}
 		//update map for next query
-		obj_last_sc_map.put(curr->get_location(), curr);
+		state->last_sc_write = curr;
 	}
 
 	/* Last SC fence in the current thread */
@@ -1049,10 +1337,14 @@ void ModelExecution::w_modification_order(ModelAction *curr)
 		if (last_sc_fence_local && int_to_id((int)i) != curr->get_tid())
 			last_sc_fence_thread_before = get_last_seq_cst_fence(int_to_id(i), last_sc_fence_local);
 
+		/* Later actions can neither happen before curr nor be ordered
+		 * before it by an SC fence, so start the search below this bound */
+		modelclock_t bound = fence_bound(curr->get_cv()->getClock(int_to_id(i)), last_sc_fence_thread_before);
+
 		/* Iterate over actions in thread, starting from most recent */
 		action_list_t *list = &(*thrd_lists)[i];
 		sllnode<ModelAction*>* rit;
-		for (rit = list->end();rit != NULL;rit=rit->getPrev()) {
+		for (rit = list->findLast(bound);rit != NULL;rit=rit->getPrev()) {
 			ModelAction *act = rit->getVal();
 			if (act == curr) {
 				/*
@@ -1116,13 +1408,13 @@ void ModelExecution::w_modification_order(ModelAction *curr)
  */
 
 ClockVector * ModelExecution::get_hb_from_write(ModelAction *rf) const {
-	SnapVector<ModelAction *> * processset = NULL;
+	scratch_action_vector_t * processset = NULL;
 	for ( ;rf != NULL;rf = rf->get_reads_from()) {
 		ASSERT(rf->is_write());
 		if (!rf->is_rmw() || (rf->is_acquire() && rf->is_release()) || rf->get_rfcv() != NULL)
 			break;
 		if (processset == NULL)
-			processset = new SnapVector<ModelAction *>();
+			processset = new scratch_action_vector_t();
 		processset->push_back(rf);
 	}
 
@@ -1179,17 +1471,23 @@ ClockVector * ModelExecution::get_hb_from_write(ModelAction *rf) const {
 void ModelExecution::add_action_to_lists(ModelAction *act, bool canprune)
 {
 	int tid = id_to_int(act->get_tid());
-	if ((act->is_fence() && act->is_seqcst()) || act->is_unlock()) {
-		simple_action_list_t *list = get_safe_ptr_action(&obj_map, act->get_location());
-		act->setActionRef(list->add_back(act));
+	LocationState *state = get_location_state(act->get_tid(), act->get_location());
+	if (act->is_unlock()) {
+		act->setActionRef(state->actions.add_back(act));
+	} else if (act->is_fence() && act->is_seqcst()) {
+		if ((int)thrd_sc_fences.size() <= tid)
+			thrd_sc_fences.resize(get_num_threads());
+		if (thrd_sc_fences[tid] == NULL)
+			thrd_sc_fences[tid] = new SnapVector<ModelAction *>();
+		thrd_sc_fences[tid]->push_back(act);
 	}
 
 	// Update action trace, a total order of all actions
 	action_trace.addAction(act);
 
 
-	// Update obj_thrd_map, a per location, per thread, order of actions
-	SnapVector<action_list_t> *vec = get_safe_ptr_vect_action(&obj_thrd_map, act->get_location());
+	// Update thrd_actions, a per location, per thread, order of actions
+	SnapVector<action_list_t> *vec = &state->thrd_actions;
 	if ((int)vec->size() <= tid) {
 		uint oldsize = vec->size();
 		vec->resize(priv->next_thread_id);
@@ -1215,7 +1513,7 @@ void ModelExecution::add_action_to_lists(ModelAction *act, bool canprune)
 
 	if (act->is_wait()) {
 		void *mutex_loc = (void *) act->get_value();
-		act->setActionRef(get_safe_ptr_action(&obj_map, mutex_loc)->add_back(act));
+		act->setActionRef(get_location_state(act->get_tid(), mutex_loc)->actions.add_back(act));
 	}
 }
 
@@ -1241,8 +1539,8 @@ void ModelExecution::add_normal_write_to_lists(ModelAction *act)
 	int tid = id_to_int(act->get_tid());
 	insertIntoActionListAndSetCV(&action_trace, act);
 
-	// Update obj_thrd_map, a per location, per thread, order of actions
-	SnapVector<action_list_t> *vec = get_safe_ptr_vect_action(&obj_thrd_map, act->get_location());
+	// Update thrd_actions, a per location, per thread, order of actions
+	SnapVector<action_list_t> *vec = &get_location_state(act->get_tid(), act->get_location())->thrd_actions;
 	if (tid >= (int)vec->size()) {
 		uint oldsize =vec->size();
 		vec->resize(priv->next_thread_id);
@@ -1261,7 +1559,7 @@ void ModelExecution::add_normal_write_to_lists(ModelAction *act)
 
 
 void ModelExecution::add_write_to_lists(ModelAction *write) {
-	SnapVector<simple_action_list_t> *vec = get_safe_ptr_vect_action(&obj_wr_thrd_map, write->get_location());
+	SnapVector<simple_action_list_t> *vec = &get_location_state(write->get_tid(), write->get_location())->thrd_writes;
 	int tid = id_to_int(write->get_tid());
 	if (tid >= (int)vec->size()) {
 		uint oldsize =vec->size();
@@ -1272,6 +1570,175 @@ void ModelExecution::add_write_to_lists(ModelAction *write) {
 	write->setActionRef((*vec)[tid].add_back(write));
 }
 
+/**
+ * @brief Get the state of a memory location, creating it if needed
+ *
+ * Each thread remembers the last location it looked up, since consecutive
+ * lookups for one action (and often for a thread's next action) hit the
+ * same location. LocationStates are never removed, so cached entries stay
+ * valid for the whole execution.
+ *
+ * @param tid The thread performing the lookup
+ * @param location The memory location
+ * @return The state of the location
+ */
+LocationState * ModelExecution::get_location_state(thread_id_t tid, const void *location)
+{
+	int thread = id_to_int(tid);
+	if (thread >= 0 && thread < (int)loc_cache.size()) {
+		struct location_cache_entry *entry = &loc_cache[thread];
+		if (entry->location == location && entry->state != NULL)
+			return entry->state;
+	}
+
+	LocationState *state = obj_state.get(location);
+	if (state == NULL) {
+		state = new LocationState();
+		obj_state.put(location, state);
+	}
+
+	if (thread >= 0) {
+		if (thread >= (int)loc_cache.size())
+			loc_cache.resize(thread + 1);
+		loc_cache[thread].location = location;
+		loc_cache[thread].state = state;
+	}
+	return state;
+}
+
+/**
+ * @param act An action on a memory location
+ * @return True if only one thread has accessed the location so far
+ */
+bool ModelExecution::is_private_location(const ModelAction *act)
+{
+	return !get_location_state(act->get_tid(), act->get_location())->shared;
+}
+
+/**
+ * @brief Check whether a new read or write can take the private location
+ * fast path
+ *
+ * The first thread to access a location owns it. Once another thread
+ * accesses it, or the owner reads something other than its own last
+ * write (e.g., an earlier non-atomic store), the location is published
+ * and handled normally from then on.
+ *
+ * @param curr The current read or write
+ * @return True if curr accesses a location private to its thread
+ */
+bool ModelExecution::check_private_access(ModelAction *curr)
+{
+	LocationState *state = get_location_state(curr->get_tid(), curr->get_location());
+	if (state->shared)
+		return false;
+	if (state->owner == THREAD_ID_T_NONE)
+		state->owner = curr->get_tid();
+
+	if (state->owner == curr->get_tid() && (!curr->is_read() || has_private_rf(state, curr)))
+		return true;
+
+	publish_location(state);
+	return false;
+}
+
+/**
+ * @brief Check whether the owner's read of a private location has exactly
+ * one write it may read from: the owner's last atomic write
+ * @param state The location's state
+ * @param curr The read, performed by the owner
+ */
+bool ModelExecution::has_private_rf(LocationState *state, ModelAction *curr)
+{
+	int tid = id_to_int(curr->get_tid());
+	return tid < (int)state->thrd_writes.size() && state->thrd_writes[tid].size() != 0 &&
+				 !hasNonAtomicStore(curr->get_location());
+}
+
+/**
+ * @brief Check whether an action can run without a scheduling step
+ *
+ * An access to a location that is private to its thread, and that will
+ * stay private, commutes with everything the other threads do, so the
+ * thread may perform it right away. If another thread's pending action
+ * touches the same location, the order matters and the scheduler decides.
+ *
+ * @param act The action a thread is about to perform
+ * @return True if act can be taken immediately
+ */
+bool ModelExecution::is_thread_local_action(ModelAction *act)
+{
+	if (!act->is_read() && !act->is_write() && !act->is_rmwc())
+		return false;
+	Thread *thr = get_thread(act);
+	if (!is_enabled(thr))
+		return false;
+
+	LocationState *state = get_location_state(act->get_tid(), act->get_location());
+	if (state->shared || state->owner != act->get_tid())
+		return false;
+	if (act->is_read() && !has_private_rf(state, act))
+		return false;
+
+	for (unsigned int i = 0;i < get_num_threads();i++) {
+		Thread *t = get_thread(int_to_id(i));
+		ModelAction *pending = t->get_pending();
+		if (t != thr && pending != NULL && pending->get_location() == act->get_location())
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Rebuild the modification order of a location that stops being
+ * private
+ *
+ * Private writes were never added to the mo_graph; they are totally
+ * ordered by the owner's program order, so add that chain now.
+ *
+ * @param state The location's state
+ */
+void ModelExecution::publish_location(LocationState *state)
+{
+	state->shared = true;
+	int owner = id_to_int(state->owner);
+	if (state->owner == THREAD_ID_T_NONE || owner >= (int)state->thrd_writes.size())
+		return;
+
+	ModelAction *prev = NULL;
+	simple_action_list_t *list = &state->thrd_writes[owner];
+	for (sllnode<ModelAction *> * it = list->begin();it != NULL;it = it->getNext()) {
+		ModelAction *write = it->getVal();
+		if (prev != NULL) {
+			if (write->is_rmw() && write->get_reads_from() == prev)
+				mo_graph->addRMWEdge(prev, write);
+			else
+				mo_graph->addEdge(prev, write);
+		}
+		prev = write;
+	}
+}
+
+/**
+ * @brief Process a read of a private location
+ *
+ * Coherence leaves only one choice: the owner's last write.
+ *
+ * @param curr The current read
+ */
+void ModelExecution::process_private_read(ModelAction *curr)
+{
+	LocationState *state = get_location_state(curr->get_tid(), curr->get_location());
+	ModelAction *rf = state->thrd_writes[id_to_int(curr->get_tid())].back();
+
+	read_from(curr, rf);
+	get_thread(curr)->set_return_value(rf->get_write_value());
+	//Update acquire fence clock vector
+	ClockVector * hbcv = get_hb_from_write(rf);
+	if (hbcv != NULL)
+		get_thread(curr)->get_acq_fence_cv()->merge(hbcv);
+}
+
 /**
  * @brief Get the last action performed by a particular Thread
  * @param tid The thread ID of the Thread in question
@@ -1300,20 +1767,6 @@ ModelAction * ModelExecution::get_last_fence_release(thread_id_t tid) const
 		return NULL;
 }
 
-/**
- * Gets the last memory_order_seq_cst write (in the total global sequence)
- * performed on a particular object (i.e., memory location), not including the
- * current action.
- * @param curr The current ModelAction; also denotes the object location to
- * check
- * @return The last seq_cst write
- */
-ModelAction * ModelExecution::get_last_seq_cst_write(ModelAction *curr) const
-{
-	void *location = curr->get_location();
-	return obj_last_sc_map.get(location);
-}
-
 /**
  * Gets the last memory_order_seq_cst fence (in the total global sequence)
  * performed in a particular thread, prior to a particular fence.
@@ -1324,29 +1777,25 @@ ModelAction * ModelExecution::get_last_seq_cst_write(ModelAction *curr) const
  */
 ModelAction * ModelExecution::get_last_seq_cst_fence(thread_id_t tid, const ModelAction *before_fence) const
 {
-	/* All fences should have location FENCE_LOCATION */
-	simple_action_list_t *list = obj_map.get(FENCE_LOCATION);
-
-	if (!list)
+	int threadid = id_to_int(tid);
+	if (threadid >= (int)thrd_sc_fences.size() || thrd_sc_fences[threadid] == NULL)
 		return NULL;
-
-	sllnode<ModelAction*>* rit = list->end();
-
-	if (before_fence) {
-		for (;rit != NULL;rit=rit->getPrev())
-			if (rit->getVal() == before_fence)
-				break;
-
-		ASSERT(rit->getVal() == before_fence);
-		rit=rit->getPrev();
-	}
-
-	for (;rit != NULL;rit=rit->getPrev()) {
-		ModelAction *act = rit->getVal();
-		if (act->is_fence() && (tid == act->get_tid()) && act->is_seqcst())
-			return act;
+	SnapVector<ModelAction *> *fences = thrd_sc_fences[threadid];
+
+	if (!before_fence)
+		return fences->empty() ? NULL : fences->back();
+
+	/* Binary search for the first fence not sequenced before before_fence */
+	modelclock_t seq = before_fence->get_seq_number();
+	uint low = 0, high = fences->size();
+	while (low < high) {
+		uint mid = (low + high) / 2;
+		if ((*fences)[mid]->get_seq_number() < seq)
+			low = mid + 1;
+		else
+			high = mid;
 	}
-	return NULL;
+	return low == 0 ? NULL : (*fences)[low - 1];
 }
 
 /**
@@ -1357,13 +1806,9 @@ ModelAction * ModelExecution::get_last_seq_cst_fence(thread_id_t tid, const Mode
  * check
  * @return The last unlock operation
  */
-ModelAction * ModelExecution::get_last_unlock(ModelAction *curr) const
+ModelAction * ModelExecution::get_last_unlock(ModelAction *curr)
 {
-	void *location = curr->get_location();
-
-	simple_action_list_t *list = obj_map.get(location);
-	if (list == NULL)
-		return NULL;
+	simple_action_list_t *list = &get_location_state(curr->get_tid(), curr->get_location())->actions;
 
 	/* Find: max({i in dom(S) | isUnlock(t_i) && samevar(t_i, t)}) */
 	sllnode<ModelAction*>* rit;
@@ -1415,61 +1860,61 @@ bool valequals(uint64_t val1, uint64_t val2, int size) {
  * @param curr is the current ModelAction that we are exploring; it must be a
  * 'read' operation.
  */
-SnapVector<ModelAction *> *  ModelExecution::build_may_read_from(ModelAction *curr)
+scratch_action_vector_t *  ModelExecution::build_may_read_from(ModelAction *curr)
 {
-	SnapVector<simple_action_list_t> *thrd_lists = obj_wr_thrd_map.get(curr->get_location());
+	LocationState *state = get_location_state(curr->get_tid(), curr->get_location());
+	SnapVector<simple_action_list_t> *thrd_lists = &state->thrd_writes;
 	unsigned int i;
 	ASSERT(curr->is_read());
 
 	ModelAction *last_sc_write = NULL;
 
 	if (curr->is_seqcst())
-		last_sc_write = get_last_seq_cst_write(curr);
+		last_sc_write = state->last_sc_write;
 
-	SnapVector<ModelAction *> * rf_set = new SnapVector<ModelAction *>();
+	scratch_action_vector_t * rf_set = new scratch_action_vector_t();
 
 	/* Iterate over all threads */
-	if (thrd_lists != NULL)
-		for (i = 0;i < thrd_lists->size();i++) {
-			/* Iterate over actions in thread, starting from most recent */
-			simple_action_list_t *list = &(*thrd_lists)[i];
-			sllnode<ModelAction *> * rit;
-			for (rit = list->end();rit != NULL;rit=rit->getPrev()) {
-				ModelAction *act = rit->getVal();
-
-				if (act == curr)
-					continue;
+	for (i = 0;i < thrd_lists->size();i++) {
+		/* Iterate over actions in thread, starting from most recent */
+		simple_action_list_t *list = &(*thrd_lists)[i];
+		sllnode<ModelAction *> * rit;
+		for (rit = list->end();rit != NULL;rit=rit->getPrev()) {
+			ModelAction *act = rit->getVal();
 
-				/* Don't consider more than one seq_cst write if we are a seq_cst read. */
-				bool allow_read = true;
-
-				if (curr->is_seqcst() && (act->is_seqcst() || (last_sc_write != NULL && act->happens_before(last_sc_write))) && act != last_sc_write)
-					allow_read = false;
-
-				/* Need to check whether we will have two RMW reading from the same value */
-				if (curr->is_rmwr()) {
-					/* It is okay if we have a failing CAS */
-					if (!curr->is_rmwrcas() ||
-							valequals(curr->get_value(), act->get_value(), curr->getSize())) {
-						//Need to make sure we aren't the second RMW
-						CycleNode * node = mo_graph->getNode_noCreate(act);
-						if (node != NULL && node->getRMW() != NULL) {
-							//we are the second RMW
-							allow_read = false;
-						}
-					}
-				}
+			if (act == curr)
+				continue;
 
-				if (allow_read) {
-					/* Only add feasible reads */
-					rf_set->push_back(act);
+			/* Don't consider more than one seq_cst write if we are a seq_cst read. */
+			bool allow_read = true;
+
+			if (curr->is_seqcst() && (act->is_seqcst() || (last_sc_write != NULL && act->happens_before(last_sc_write))) && act != last_sc_write)
+				allow_read = false;
+
+			/* Need to check whether we will have two RMW reading from the same value */
+			if (curr->is_rmwr()) {
+				/* It is okay if we have a failing CAS */
+				if (!curr->is_rmwrcas() ||
+						valequals(curr->get_value(), act->get_value(), curr->getSize())) {
+					//Need to make sure we aren't the second RMW
+					CycleNode * node = mo_graph->getNode_noCreate(act);
+					if (node != NULL && node->getRMW() != NULL) {
+						//we are the second RMW
+						allow_read = false;
+					}
 				}
+			}
 
-				/* Include at most one act per-thread that "happens before" curr */
-				if (act->happens_before(curr))
-					break;
+			if (allow_read) {
+				/* Only add feasible reads */
+				rf_set->push_back(act);
 			}
+
+			/* Include at most one act per-thread that "happens before" curr */
+			if (act->happens_before(curr))
+				break;
 		}
+	}
 
 	if (DBG_ENABLED()) {
 		model_print("Reached read action:\n");
@@ -1708,6 +2153,7 @@ Thread * ModelExecution::take_step(ModelAction *curr)
 {
 	Thread *curr_thrd = get_thread(curr);
 	ASSERT(curr_thrd->get_state() == THREAD_READY);
+	fuzzer->pending_consumed(curr_thrd);
 
 	ASSERT(check_action_enabled(curr));	/* May have side effects? */
 	curr = check_current_action(curr);
@@ -1729,32 +2175,34 @@ void ModelExecution::removeAction(ModelAction *act) {
 	{
 		action_trace.removeAction(act);
 	}
+	LocationState *state = get_location_state(act->get_tid(), act->get_location());
 	{
-		SnapVector<action_list_t> *vec = get_safe_ptr_vect_action(&obj_thrd_map, act->get_location());
+		SnapVector<action_list_t> *vec = &state->thrd_actions;
 		(*vec)[act->get_tid()].removeAction(act);
 	}
-	if ((act->is_fence() && act->is_seqcst()) || act->is_unlock()) {
+	if (act->is_fence() && act->is_seqcst()) {
+		thrd_sc_fences[id_to_int(act->get_tid())]->remove(act);
+	} else if (act->is_unlock()) {
 		sllnode<ModelAction *> * listref = act->getActionRef();
 		if (listref != NULL) {
-			simple_action_list_t *list = get_safe_ptr_action(&obj_map, act->get_location());
-			list->erase(listref);
+			state->actions.erase(listref);
 		}
 	} else if (act->is_wait()) {
 		sllnode<ModelAction *> * listref = act->getActionRef();
 		if (listref != NULL) {
 			void *mutex_loc = (void *) act->get_value();
-			get_safe_ptr_action(&obj_map, mutex_loc)->erase(listref);
+			get_location_state(act->get_tid(), mutex_loc)->actions.erase(listref);
 		}
 	} else if (act->is_free()) {
 		sllnode<ModelAction *> * listref = act->getActionRef();
 		if (listref != NULL) {
-			SnapVector<simple_action_list_t> *vec = get_safe_ptr_vect_action(&obj_wr_thrd_map, act->get_location());
+			SnapVector<simple_action_list_t> *vec = &state->thrd_writes;
 			(*vec)[act->get_tid()].erase(listref);
 		}
 
-		//Clear it from last_sc_map
-		if (obj_last_sc_map.get(act->get_location()) == act) {
-			obj_last_sc_map.remove(act->get_location());
+		//Clear it from last_sc_write
+		if (state->last_sc_write == act) {
+			state->last_sc_write = NULL;
 		}
 
 		//Remove from Cyclegraph
@@ -1800,7 +2248,7 @@ void ModelExecution::collectActions() {
 
 	//Compute minimal clock vector for all live threads
 	ClockVector *cvmin = computeMinimalCV();
-	SnapVector<CycleNode *> * queue = new SnapVector<CycleNode *>();
+	scratch_node_vector_t * queue = new scratch_node_vector_t();
 	modelclock_t maxtofree = priv->used_sequence_numbers - params->traceminsize;
 
 	//Next walk action trace...  When we hit an action, see if it is
@@ -1831,7 +2279,16 @@ void ModelExecution::collectActions() {
 
 			//Mark everything earlier in MO graph to be freed
 			CycleNode * cn = mo_graph->getNode_noCreate(write);
-			if (cn != NULL) {
+			if (cn == NULL && is_private_location(write)) {
+				//Private writes are in mo order in the owner's write list
+				sllnode<ModelAction *> * wit;
+				for (wit = write->getActionRef()->getPrev();wit != NULL;wit = wit->getPrev()) {
+					ModelAction * prevact = wit->getVal();
+					if (prevact->get_type() == READY_FREE)
+						break;
+					prevact->set_free();
+				}
+			} else if (cn != NULL) {
 				queue->push_back(cn);
 				while(!queue->empty()) {
 					CycleNode * node = queue->back();
@@ -1995,3 +2452,13 @@ void ModelExecution::collectActions() {
 Fuzzer * ModelExecution::getFuzzer() {
 	return fuzzer;
 }
+
+/**
+ * @brief Replace the default Fuzzer, e.g., as selected by the options
+ * @param f The new Fuzzer
+ */
+void ModelExecution::setFuzzer(Fuzzer *f) {
+	delete fuzzer;
+	fuzzer = f;
+	fuzzer->register_engine(model, this);
+}
@@ -27,6 +27,72 @@ struct PendingFutureValue {
 	ModelAction *reader;
 };
 
+/** @brief Per-location state, kept together so one lookup serves an action */
+struct LocationState {
+	LocationState() :
+		actions(),
+		waiters(),
+		thrd_actions(),
+		thrd_writes(),
+		last_sc_write(NULL),
+		num_writes(0),
+		owner(THREAD_ID_T_NONE),
+		shared(false)
+	{ }
+
+	/** @brief Trace of unlocks and waits on this location */
+	simple_action_list_t actions;
+
+	/** @brief Threads waiting on this location (a condition variable) */
+	simple_action_list_t waiters;
+
+	/** @brief Per-thread list of actions on this location */
+	SnapVector<action_list_t> thrd_actions;
+
+	/** @brief Per-thread list of writes to this location */
+	SnapVector<simple_action_list_t> thrd_writes;
+
+	/** @brief The last seq_cst write to this location */
+	ModelAction *last_sc_write;
+
+	/** @brief Number of writes to this location so far */
+	unsigned int num_writes;
+
+	/** @brief The first thread to read or write this location */
+	thread_id_t owner;
+
+	/**
+	 * @brief Whether a second thread has accessed this location
+	 *
+	 * Until then, the location's writes are totally ordered by the
+	 * owner's program order, so they get no mo_graph nodes and reads
+	 * simply read the owner's last write.
+	 */
+	bool shared;
+
+	SNAPSHOTALLOC
+};
+
+/** @brief One-entry cache of the last location a thread touched */
+struct location_cache_entry {
+	const void *location;
+	LocationState *state;
+};
+
+/**
+ * @brief A thread's run of identical reads: the same position, location
+ * and value, with no write to the location in between
+ */
+struct spin_state {
+	const char *position;
+	const void *location;
+	uint64_t value;
+	/** @brief The location's number of writes when the run started */
+	unsigned int num_writes;
+	/** @brief Length of the run */
+	unsigned int count;
+};
+
 #ifdef COLLECT_STAT
 void print_atomic_accesses();
 #endif
@@ -68,6 +134,7 @@ public:
 	ModelAction * get_last_action(thread_id_t tid) const;
 
 	bool check_action_enabled(ModelAction *curr);
+	bool is_thread_local_action(ModelAction *act);
 
 	void assert_bug(const char *msg);
 
@@ -77,12 +144,15 @@ public:
 
 	bool has_asserted() const;
 	void set_assert();
+	void set_truncated();
+	bool is_truncated() const;
 	bool is_complete_execution() const;
 
 	bool is_deadlocked() const;
 
 	action_list_t * get_action_trace() { return &action_trace; }
 	Fuzzer * getFuzzer();
+	void setFuzzer(Fuzzer *f);
 	CycleGraph * const get_mo_graph() { return mo_graph; }
 	HashTable<pthread_cond_t *, cdsc::snapcondition_variable *, uintptr_t, 4> * getCondMap() {return &cond_map;}
 	HashTable<pthread_mutex_t *, cdsc::snapmutex *, uintptr_t, 4> * getMutexMap() {return &mutex_map;}
@@ -93,6 +163,11 @@ public:
 	void restore_last_seq_num();
 	void collectActions();
 	modelclock_t get_curr_seq_num();
+	uint64_t get_virtual_time() const;
+	unsigned int get_num_spin_loops() const;
+	uint64_t get_trace_hash() const;
+	uint64_t get_virtual_deadline(const struct timespec *abstime) const;
+	void skip_to_next_wakeup();
 #ifdef TLS
 	pthread_key_t getPthreadKey() {return pthreadkey;}
 #endif
@@ -101,10 +176,15 @@ private:
 	int get_execution_number() const;
 	bool should_wake_up(const ModelAction *curr, const Thread *thread) const;
 	void wake_up_sleeping_actions(ModelAction *curr);
+	void wake_up_sleeper(Thread *thr);
+	void wake_up_waiter(Thread *thr);
+	void check_spinning(ModelAction *curr);
+	void hash_action(const ModelAction *curr);
+	void wake_up_spinners(const ModelAction *write);
 	modelclock_t get_next_seq_num();
 	bool next_execution();
 	bool initialize_curr_action(ModelAction **curr);
-	bool process_read(ModelAction *curr, SnapVector<ModelAction *> * rf_set);
+	bool process_read(ModelAction *curr, scratch_action_vector_t * rf_set);
 	void process_write(ModelAction *curr);
 	void process_fence(ModelAction *curr);
 	bool process_mutex(ModelAction *curr);
@@ -115,12 +195,17 @@ private:
 	void add_normal_write_to_lists(ModelAction *act);
 	void add_write_to_lists(ModelAction *act);
 	ModelAction * get_last_fence_release(thread_id_t tid) const;
-	ModelAction * get_last_seq_cst_write(ModelAction *curr) const;
+	LocationState * get_location_state(thread_id_t tid, const void *location);
+	bool is_private_location(const ModelAction *act);
+	bool check_private_access(ModelAction *curr);
+	bool has_private_rf(LocationState *state, ModelAction *curr);
+	void publish_location(LocationState *state);
+	void process_private_read(ModelAction *curr);
 	ModelAction * get_last_seq_cst_fence(thread_id_t tid, const ModelAction *before_fence) const;
-	ModelAction * get_last_unlock(ModelAction *curr) const;
-	SnapVector<ModelAction *> * build_may_read_from(ModelAction *curr);
+	ModelAction * get_last_unlock(ModelAction *curr);
+	scratch_action_vector_t * build_may_read_from(ModelAction *curr);
 	ModelAction * process_rmw(ModelAction *curr);
-	bool r_modification_order(ModelAction *curr, const ModelAction *rf, SnapVector<ModelAction *> *priorset, bool *canprune);
+	bool r_modification_order(ModelAction *curr, const ModelAction *rf, scratch_action_vector_t *priorset, bool *canprune);
 	void w_modification_order(ModelAction *curr);
 	ClockVector * get_hb_from_write(ModelAction *rf) const;
 	ModelAction * convertNonAtomicStore(void*);
@@ -145,24 +230,18 @@ private:
 	action_list_t action_trace;
 
 
-	/** Per-object list of actions. Maps an object (i.e., memory location)
-	 * to a trace of all actions performed on the object.
-	 * Used only for SC fences, unlocks, & wait.
-	 */
-	HashTable<const void *, simple_action_list_t *, uintptr_t, 2> obj_map;
-
-	/** Per-object list of actions. Maps an object (i.e., memory location)
-	 * to a trace of all actions performed on the object. */
-	HashTable<const void *, simple_action_list_t *, uintptr_t, 2> condvar_waiters_map;
-
-	/** Per-object list of actions that each thread performed. */
-	HashTable<const void *, SnapVector<action_list_t> *, uintptr_t, 2> obj_thrd_map;
+	/** Per-object state. Maps an object (i.e., memory location) to the
+	 * lists of actions performed on it; see LocationState. */
+	HashTable<const void *, LocationState *, uintptr_t, 2> obj_state;
 
-	/** Per-object list of writes that each thread performed. */
-	HashTable<const void *, SnapVector<simple_action_list_t> *, uintptr_t, 2> obj_wr_thrd_map;
+	/** Per-thread cache of the last obj_state lookup */
+	SnapVector<struct location_cache_entry> loc_cache;
 
-	HashTable<const void *, ModelAction *, uintptr_t, 4> obj_last_sc_map;
+	/** Per-thread run of identical reads, for spin-loop detection */
+	SnapVector<struct spin_state> thrd_spin;
 
+	/** Per-thread running hash of the actions it ran; see hash_action() */
+	SnapVector<uint64_t> thrd_hash;
 
 	HashTable<pthread_mutex_t *, cdsc::snapmutex *, uintptr_t, 4> mutex_map;
 	HashTable<pthread_cond_t *, cdsc::snapcondition_variable *, uintptr_t, 4> cond_map;
@@ -177,6 +256,9 @@ private:
 	SnapVector<ModelAction *> thrd_last_action;
 	SnapVector<ModelAction *> thrd_last_fence_release;
 
+	/** Per-thread seq_cst fences, in sequence order */
+	SnapVector<SnapVector<ModelAction *> *> thrd_sc_fences;
+
 	/** A special model-checker Thread; used for associating with
 	 *  model-checker-related ModelAcitons */
 	Thread *model_thread;
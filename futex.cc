@@ -38,11 +38,6 @@ namespace std _GLIBCXX_VISIBILITY(default)
 			return true;
 		}
 
-		// if a timeout is specified, return immedialy. Letting the scheduler decide how long this thread will wait.
-		if (__has_timeout) {
-			return true;
-		}
-
 		ModelExecution *execution = model->get_execution();
 
 		cdsc::snapcondition_variable *v = new cdsc::snapcondition_variable();
@@ -51,6 +46,12 @@ namespace std _GLIBCXX_VISIBILITY(default)
 		execution->getCondMap()->put( (pthread_cond_t *) __addr, v);
 		execution->getMutexMap()->put( (pthread_mutex_t *) __addr, m);
 
+		// the timeout is an absolute CLOCK_REALTIME time; return false if it passes on the virtual clock
+		if (__has_timeout) {
+			struct timespec abstime = { (time_t) __s.count(), (long) __ns.count() };
+			return v->timed_wait(*m, &abstime) != ETIMEDOUT;
+		}
+
 		v->wait(*m);
 		return true;
 	}
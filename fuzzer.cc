@@ -1,24 +1,26 @@
 #include "fuzzer.h"
 #include <stdlib.h>
+#include "prng.h"
 #include "threads-model.h"
 #include "model.h"
+#include "execution.h"
 #include "action.h"
 
-int Fuzzer::selectWrite(ModelAction *read, SnapVector<ModelAction *> * rf_set) {
-	int random_index = random() % rf_set->size();
+int Fuzzer::selectWrite(ModelAction *read, scratch_action_vector_t * rf_set) {
+	int random_index = model_random() % rf_set->size();
 	return random_index;
 }
 
-Thread * Fuzzer::selectThread(int * threadlist, int numthreads) {
-	int random_index = random() % numthreads;
-	int thread = threadlist[random_index];
+Thread * Fuzzer::selectThread(ThreadSet * threads) {
+	int random_index = model_random() % threads->size();
+	int thread = threads->select(random_index);
 	thread_id_t curr_tid = int_to_id(thread);
 	return model->get_thread(curr_tid);
 }
 
 Thread * Fuzzer::selectNotify(simple_action_list_t * waiters) {
 	int numwaiters = waiters->size();
-	int random_index = random() % numwaiters;
+	int random_index = model_random() % numwaiters;
 	sllnode<ModelAction*> * it = waiters->begin();
 	while(random_index--)
 		it=it->getNext();
@@ -32,14 +34,15 @@ bool Fuzzer::shouldSleep(const ModelAction *sleep) {
 }
 
 bool Fuzzer::shouldWake(const ModelAction *sleep) {
-	struct timespec currtime;
-	clock_gettime(CLOCK_MONOTONIC, &currtime);
-	uint64_t lcurrtime = currtime.tv_sec * 1000000000 + currtime.tv_nsec;
-
-	return ((sleep->get_time()+sleep->get_value()) < lcurrtime);
+	uint64_t now = model->get_execution()->get_virtual_time();
+	return sleep->get_wakeup_time() <= now;
 }
 
 bool Fuzzer::shouldWait(const ModelAction * act)
 {
+	/* A timed wait either waits for a notify or its deadline, or times
+	 * out right away */
+	if (act->is_timed())
+		return model_random() & 1;
 	return true;
 }
@@ -4,18 +4,34 @@
 #include "mymemory.h"
 #include "stl-model.h"
 #include "threads-model.h"
+#include "threadset.h"
 
 class Fuzzer {
 public:
 	Fuzzer() {}
-	virtual int selectWrite(ModelAction *read, SnapVector<ModelAction *>* rf_set);
+	virtual ~Fuzzer() {}
+	virtual int selectWrite(ModelAction *read, scratch_action_vector_t * rf_set);
 	virtual bool has_paused_threads() { return false; }
-	virtual Thread * selectThread(int * threadlist, int numthreads);
+	virtual Thread * selectThread(ThreadSet * threads);
 
-	Thread * selectNotify(simple_action_list_t * waiters);
-	bool shouldSleep(const ModelAction *sleep);
-	bool shouldWake(const ModelAction *sleep);
+	virtual Thread * selectNotify(simple_action_list_t * waiters);
+	virtual bool shouldSleep(const ModelAction *sleep);
+	virtual bool shouldWake(const ModelAction *sleep);
 	virtual bool shouldWait(const ModelAction *wait);
+	/** @brief Called when a thread's pending action is taken or dropped */
+	virtual void pending_consumed(Thread *thread) {}
+	/** @brief Called at the end of each execution, after its end-of-execution
+	 *  bug checks */
+	virtual void execution_finished() {}
+	/** @brief Called at the end of each execution
+	 *  @return False if there is nothing left to explore */
+	virtual bool has_more_executions() { return true; }
+	/** @brief Called in the parent process instead, when an execution's
+	 *  process died
+	 *  @return False if there is nothing left to explore */
+	virtual bool execution_crashed() { return true; }
+	/** @brief Print the fuzzer's campaign statistics */
+	virtual void print_stats() {}
 	virtual void register_engine(ModelChecker * _model, ModelExecution * execution) {}
 	SNAPSHOTALLOC
 private:
@@ -25,6 +25,7 @@ public:
 	~mutex() {}
 	void lock();
 	bool try_lock();
+	int timed_lock(const struct timespec *abstime);
 	void unlock();
 	struct mutex_state * get_state() {return &state;}
 
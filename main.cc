@@ -5,6 +5,8 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <string.h>
+#include <limits.h>
+#include <pthread.h>
 
 #include "common.h"
 #include "output.h"
@@ -24,6 +26,22 @@ void param_defaults(struct model_params *params)
 	params->traceminsize = 0;
 	params->checkthreshold = 500000;
 	params->removevisible = false;
+	params->batchlocal = false;
+	params->stacksize = STACK_SIZE;
+	params->stackprefault = 0;
+	params->fuzzer = FUZZER_RANDOM;
+	params->pctdepth = 3;
+	params->preemptionbound = 2;
+	params->depthbound = 100;
+	params->recordprefix = NULL;
+	params->replayfile = NULL;
+	params->seed = 423121;
+	params->startexec = 1;
+	params->maxactions = 0;
+	params->exectime = 0;
+	params->timebudget = 0;
+	params->saturation = 0;
+	params->unseenbound = 0;
 	params->nofork = false;
 }
 
@@ -59,11 +77,71 @@ static void print_usage(struct model_params *params)
 		"                            Default: %u\n"
 		"-f, --freqfree=NUM          Frequency to free actions\n"
 		"                            Default: %u\n"
-		"-r, --removevisible         Free visible writes\n",
+		"-r, --removevisible         Free visible writes\n"
+		"-b, --batchlocal            Run actions on thread-private locations\n"
+		"                            immediately, without a scheduling step\n"
+		"-s, --stacksize=NUM         Stack size of each thread, in KB\n"
+		"                            Minimum: %zu, default: %zu\n"
+		"-p, --prefault=NUM          Fault in the top NUM pages of each thread\n"
+		"                            stack when it is allocated\n"
+		"                            Default: %u\n",
 		params->verbose,
 		params->maxexecutions,
 		params->traceminsize,
-		params->checkthreshold);
+		params->checkthreshold,
+		(size_t)PTHREAD_STACK_MIN / 1024,
+		params->stacksize / 1024,
+		params->stackprefault);
+	/* model_print() truncates at 2048 bytes, so print in parts */
+	model_print(
+		"-z, --fuzzer=NAME           Thread scheduling fuzzer: random, pct, pos,\n"
+		"                            dpor or coverage\n"
+		"                            Default: random\n"
+		"-d, --pctdepth=NUM          Bug depth targeted by the pct fuzzer\n"
+		"                            Default: %u\n"
+		"-c, --preemptions=NUM       Preemptions per execution explored by the\n"
+		"                            dpor fuzzer; -1 for no bound\n"
+		"                            Default: %d\n"
+		"-k, --depthbound=NUM        Decisions per execution explored by the\n"
+		"                            dpor fuzzer; later ones are random\n"
+		"                            Default: %u\n"
+		"-w, --record=PREFIX         Save the decisions of each buggy execution\n"
+		"                            to PREFIX-<execution>.replay\n"
+		"-y, --replay=FILE           Run one execution that follows the decisions\n"
+		"                            saved in FILE\n"
+		"-e, --seed=NUM              Campaign seed\n"
+		"                            Default: %llu\n"
+		"-j, --start-exec=NUM        Number of the first execution; with -e and\n"
+		"                            -x 1, reruns that execution of a campaign\n"
+		"                            Default: %d\n",
+		params->pctdepth,
+		params->preemptionbound,
+		params->depthbound,
+		(unsigned long long)params->seed,
+		params->startexec);
+	model_print(
+		"-a, --maxactions=NUM        Truncate an execution after NUM actions;\n"
+		"                            0 for no bound\n"
+		"                            Default: %u\n"
+		"-l, --exectime=NUM          Truncate an execution after NUM milliseconds;\n"
+		"                            0 for no bound\n"
+		"                            Default: %u\n"
+		"-u, --time-budget=NUM       Start no execution after NUM seconds, and\n"
+		"                            truncate the one running then; 0 for no bound\n"
+		"                            Default: %u\n"
+		"-q, --saturation=NUM        Stop after NUM executions in a row show no new\n"
+		"                            reads-from pair, mo edge, bug or trace hash;\n"
+		"                            0 to never stop this way\n"
+		"                            Default: %u\n"
+		"-g, --unseen=NUM            Stop once the estimated chance that an\n"
+		"                            execution has a new trace hash is below NUM;\n"
+		"                            0 to never stop this way\n"
+		"                            Default: %.2f\n",
+		params->maxactions,
+		params->exectime,
+		params->timebudget,
+		params->saturation,
+		params->unseenbound);
 	model_print("Analysis plugins:\n");
 	for(unsigned int i=0;i<registeredanalysis->size();i++) {
 		TraceAnalysis * analysis=(*registeredanalysis)[i];
@@ -72,6 +150,15 @@ static void print_usage(struct model_params *params)
 	exit(EXIT_SUCCESS);
 }
 
+/** @brief Copy an option's argument out of the option string */
+static char * copy_string(const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *copy = (char *)model_malloc(len);
+	memcpy(copy, str, len);
+	return copy;
+}
+
 bool install_plugin(char * name) {
 	ModelVector<TraceAnalysis *> * registeredanalysis=getRegisteredTraceAnalysis();
 	ModelVector<TraceAnalysis *> * installedanalysis=getInstalledTraceAnalysis();
@@ -88,16 +175,32 @@ bool install_plugin(char * name) {
 }
 
 void parse_options(struct model_params *params) {
-	const char *shortopts = "hrnt:o:x:v:m:f:";
+	const char *shortopts = "hrbnt:o:x:v:m:f:s:p:z:d:c:k:w:y:e:j:a:l:u:q:g:";
 	const struct option longopts[] = {
 		{"help", no_argument, NULL, 'h'},
 		{"removevisible", no_argument, NULL, 'r'},
+		{"batchlocal", no_argument, NULL, 'b'},
 		{"analysis", required_argument, NULL, 't'},
 		{"options", required_argument, NULL, 'o'},
 		{"maxexecutions", required_argument, NULL, 'x'},
 		{"verbose", optional_argument, NULL, 'v'},
 		{"minsize", required_argument, NULL, 'm'},
 		{"freqfree", required_argument, NULL, 'f'},
+		{"stacksize", required_argument, NULL, 's'},
+		{"prefault", required_argument, NULL, 'p'},
+		{"fuzzer", required_argument, NULL, 'z'},
+		{"pctdepth", required_argument, NULL, 'd'},
+		{"preemptions", required_argument, NULL, 'c'},
+		{"depthbound", required_argument, NULL, 'k'},
+		{"record", required_argument, NULL, 'w'},
+		{"replay", required_argument, NULL, 'y'},
+		{"seed", required_argument, NULL, 'e'},
+		{"start-exec", required_argument, NULL, 'j'},
+		{"maxactions", required_argument, NULL, 'a'},
+		{"exectime", required_argument, NULL, 'l'},
+		{"time-budget", required_argument, NULL, 'u'},
+		{"saturation", required_argument, NULL, 'q'},
+		{"unseen", required_argument, NULL, 'g'},
 		{0, 0, 0, 0}	/* Terminator */
 	};
 	int opt, longindex;
@@ -153,6 +256,75 @@ void parse_options(struct model_params *params) {
 		case 'r':
 			params->removevisible = true;
 			break;
+		case 'b':
+			params->batchlocal = true;
+			break;
+		case 's':
+		{
+			/* Anything smaller cannot even run the thread's entry code */
+			int kb = atoi(optarg);
+			if (kb <= 0 || (size_t)kb * 1024 < (size_t)PTHREAD_STACK_MIN)
+				error = true;
+			else
+				params->stacksize = (size_t)kb * 1024;
+		}
+		break;
+		case 'p':
+			if (atoi(optarg) < 0)
+				error = true;
+			else
+				params->stackprefault = atoi(optarg);
+			break;
+		case 'z':
+			if (strcmp(optarg, "random") == 0)
+				params->fuzzer = FUZZER_RANDOM;
+			else if (strcmp(optarg, "pct") == 0)
+				params->fuzzer = FUZZER_PCT;
+			else if (strcmp(optarg, "pos") == 0)
+				params->fuzzer = FUZZER_POS;
+			else if (strcmp(optarg, "dpor") == 0)
+				params->fuzzer = FUZZER_DPOR;
+			else if (strcmp(optarg, "coverage") == 0)
+				params->fuzzer = FUZZER_COVERAGE;
+			else
+				error = true;
+			break;
+		case 'd':
+			params->pctdepth = atoi(optarg);
+			break;
+		case 'c':
+			params->preemptionbound = atoi(optarg);
+			break;
+		case 'k':
+			params->depthbound = atoi(optarg);
+			break;
+		case 'w':
+			params->recordprefix = copy_string(optarg);
+			break;
+		case 'y':
+			params->replayfile = copy_string(optarg);
+			break;
+		case 'e':
+			params->seed = strtoull(optarg, NULL, 0);
+			break;
+		case 'j':
+			params->startexec = atoi(optarg);
+			break;
+		case 'a':
+			params->maxactions = atoi(optarg);
+			break;
+		case 'l':
+			params->exectime = atoi(optarg);
+			break;
+		case 'u':
+			params->timebudget = atoi(optarg);
+			break;
+		case 'q':
+			params->saturation = atoi(optarg);
+			break;
+		case 'g':
+			params->unseenbound = atof(optarg);
+			break;
 		case 'o':
 		{
 			ModelVector<TraceAnalysis *> * analyses = getInstalledTraceAnalysis();
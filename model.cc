@@ -4,6 +4,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <cstdlib>
+#include <time.h>
 
 #include "model.h"
 #include "action.h"
@@ -19,6 +20,13 @@
 #include "bugmessage.h"
 #include "params.h"
 #include "plugins.h"
+#include "pctfuzzer.h"
+#include "posfuzzer.h"
+#include "dporfuzzer.h"
+#include "coveragefuzzer.h"
+#include "replayfuzzer.h"
+#include "prng.h"
+#include "cyclegraph.h"
 
 ModelChecker *model = NULL;
 
@@ -27,18 +35,36 @@ void placeholder(void *) {
 }
 
 #include <signal.h>
+#include <sys/wait.h>
 
 #define SIGSTACKSIZE 65536
-static void mprot_handle_pf(int sig, siginfo_t *si, void *unused)
+static void handle_crash(int sig, siginfo_t *si, void *ctx)
 {
-	model_print("Segmentation fault at %p\n", si->si_addr);
+	void *pc = NULL;
+#if defined(__x86_64__)
+	pc = (void *)((ucontext_t *)ctx)->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+	pc = (void *)((ucontext_t *)ctx)->uc_mcontext.gregs[REG_EIP];
+#elif defined(__aarch64__)
+	pc = (void *)((ucontext_t *)ctx)->uc_mcontext.pc;
+#endif
+	/* Only a fault has a faulting address; abort() and kill() do not */
+	void *addr = si->si_code > 0 ? si->si_addr : NULL;
+	/* Leave the details where the parent process can find them */
+	if (model != NULL)
+		model->set_crash(sig, pc, addr);
+	model_print("Caught signal %d at pc %p, address %p\n", sig, pc, addr);
 	model_print("For debugging, place breakpoint at: %s:%d\n",
 							__FILE__, __LINE__);
 	print_trace();	// Trace printing may cause dynamic memory allocation
-	while(1)
-		;
+
+	/* Die of the signal, so that waitpid() in the parent reports it */
+	signal(sig, SIG_DFL);
+	raise(sig);
 }
 
+static const int crash_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+
 void install_handler() {
 	stack_t ss;
 	ss.ss_sp = model_malloc(SIGSTACKSIZE);
@@ -48,14 +74,24 @@ void install_handler() {
 	struct sigaction sa;
 	sa.sa_flags = SA_SIGINFO | SA_NODEFER | SA_RESTART | SA_ONSTACK;
 	sigemptyset(&sa.sa_mask);
-	sa.sa_sigaction = mprot_handle_pf;
+	sa.sa_sigaction = handle_crash;
 
-	if (sigaction(SIGSEGV, &sa, NULL) == -1) {
-		perror("sigaction(SIGSEGV)");
-		exit(EXIT_FAILURE);
+	for (unsigned int i = 0;i < sizeof(crash_signals) / sizeof(crash_signals[0]);i++) {
+		if (sigaction(crash_signals[i], &sa, NULL) == -1) {
+			perror("sigaction");
+			exit(EXIT_FAILURE);
+		}
 	}
 }
 
+/** @return The monotonic clock, in nanoseconds */
+static uint64_t monotonic_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
 void createModelIfNotExist() {
 	if (!model) {
 		snapshot_system_init(100000);
@@ -71,8 +107,13 @@ ModelChecker::ModelChecker() :
 	scheduler(new Scheduler()),
 	history(new ModelHistory()),
 	execution(new ModelExecution(this, scheduler)),
+	crash(),
+	trace_hashes(new trace_hash_count_t()),
+	behaviors(new behavior_set_t()),
 	execution_number(1),
 	curr_thread_num(1),
+	campaign_deadline(0),
+	exec_deadline(0),
 	trace_analyses(),
 	inspect_plugin(NULL)
 {
@@ -81,16 +122,38 @@ ModelChecker::ModelChecker() :
 							"Distributed under the GPLv2\n"
 							"Written by Weiyu Luo, Brian Norris, and Brian Demsky\n\n");
 	memset(&stats,0,sizeof(struct execution_stats));
+	register_plugins();
+	execution->setParams(&params);
+	param_defaults(&params);
+	parse_options(&params);
+	execution_number = params.startexec;
+	if (params.timebudget != 0)
+		campaign_deadline = monotonic_ns() + (uint64_t)params.timebudget * 1000000000;
+	/* Before the first fork, so that every execution shares the pool */
+	stack_pool_init(params.stacksize, params.stackprefault);
+	Fuzzer *fuzzer = NULL;
+	if (params.fuzzer == FUZZER_PCT)
+		fuzzer = new PCTFuzzer(params.pctdepth);
+	else if (params.fuzzer == FUZZER_POS)
+		fuzzer = new POSFuzzer();
+	else if (params.fuzzer == FUZZER_DPOR)
+		fuzzer = new DPORFuzzer(params.preemptionbound, params.depthbound);
+	else if (params.fuzzer == FUZZER_COVERAGE)
+		fuzzer = new CoverageFuzzer();
+	if (params.recordprefix != NULL || params.replayfile != NULL) {
+		fuzzer = new ReplayFuzzer(fuzzer != NULL ? fuzzer : new Fuzzer(), params.recordprefix, params.replayfile);
+		/* A replay reproduces one execution */
+		if (params.replayfile != NULL)
+			params.maxexecutions = 1;
+	}
+	if (fuzzer != NULL)
+		execution->setFuzzer(fuzzer);
 	init_thread = new Thread(execution->get_next_id(), (thrd_t *) model_malloc(sizeof(thrd_t)), &placeholder, NULL, NULL);
 #ifdef TLS
 	init_thread->setTLS((char *)get_tls_addr());
 #endif
 	execution->add_thread(init_thread);
 	scheduler->set_current_thread(init_thread);
-	register_plugins();
-	execution->setParams(&params);
-	param_defaults(&params);
-	parse_options(&params);
 	initRaceDetector();
 	/* Configure output redirection for the model-checker */
 	install_handler();
@@ -232,8 +295,15 @@ void ModelChecker::print_bugs() const
 void ModelChecker::record_stats()
 {
 	stats.num_total ++;
+	stats.num_spin_loops += execution->get_num_spin_loops();
+	if (record_behaviors())
+		stats.num_stale = 0;
+	else
+		stats.num_stale ++;
 	if (execution->have_bug_reports())
 		stats.num_buggy_executions ++;
+	else if (execution->is_truncated())
+		stats.num_truncated ++;
 	else if (execution->is_complete_execution())
 		stats.num_complete ++;
 	else {
@@ -247,12 +317,110 @@ void ModelChecker::record_stats()
 	}
 }
 
+/** @return A key for an action's source position and thread */
+static uint64_t behavior_key(const ModelAction *act)
+{
+	const char *position = act->get_position();
+	uint64_t key = position != NULL ? (uintptr_t)position : (uintptr_t)act->get_type();
+	return key ^ ((uint64_t)id_to_int(act->get_tid()) << 48);
+}
+
+/** @return A hash of one behavior, a pair of keys of the given kind */
+static uint64_t behavior_hash(enum behavior_kind kind, uint64_t from, uint64_t to)
+{
+	uint64_t hash = (from * 0x9E3779B97F4A7C15ULL) ^ (to * 0xC2B2AE3D27D4EB4FULL) ^ kind;
+	hash ^= hash >> 29;
+	hash *= 0xBF58476D1CE4E5B9ULL;
+	return hash ^ (hash >> 32);
+}
+
+/** @return The FNV-1a hash of a string */
+static uint64_t string_hash(const char *str)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (;*str;str++)
+		hash = (hash ^ (unsigned char)*str) * 0x100000001B3ULL;
+	return hash;
+}
+
+/** @return Whether the behavior is new; counts it if so */
+bool ModelChecker::add_behavior(enum behavior_kind kind, uint64_t hash)
+{
+	if (!behaviors->add(hash))
+		return false;
+	stats.num_behaviors[kind] ++;
+	return true;
+}
+
+/**
+ * @brief Add this execution's behaviors to those of earlier executions
+ *
+ * The execution's trace hash always counts, unless the execution was
+ * truncated. With -q, so do its reads-from pairs and modification order
+ * edges, each as a pair of source positions, and its bug reports.
+ *
+ * @return Whether any of them was new
+ */
+bool ModelChecker::record_behaviors()
+{
+	bool found = false;
+	/* A truncated execution's hash is only that of a prefix */
+	if (!execution->is_truncated()) {
+		uint64_t hash = execution->get_trace_hash();
+		unsigned int count = trace_hashes->get(hash);
+		trace_hashes->put(hash, count + 1);
+		if (count == 0) {
+			stats.num_distinct ++;
+			stats.num_singletons ++;
+			found = true;
+		} else {
+			stats.num_duplicate ++;
+			if (count == 1)
+				stats.num_singletons --;
+		}
+	}
+	if (params.saturation == 0)
+		return found;
+
+	CycleGraph *mo_graph = execution->get_mo_graph();
+	action_list_t *trace = execution->get_action_trace();
+	for (sllnode<ModelAction *> *it = trace->begin();it != NULL;it = it->getNext()) {
+		const ModelAction *act = it->getVal();
+		if (act->is_read() && act->get_reads_from() != NULL)
+			found |= add_behavior(BEHAVIOR_RF, behavior_hash(BEHAVIOR_RF, behavior_key(act->get_reads_from()), behavior_key(act)));
+		if (act->is_write()) {
+			CycleNode *node = mo_graph->getNode_noCreate(act);
+			if (node == NULL)
+				continue;
+			for (unsigned int i = 0;i < node->getNumEdges();i++)
+				found |= add_behavior(BEHAVIOR_MO, behavior_hash(BEHAVIOR_MO, behavior_key(act), behavior_key(node->getEdge(i)->getAction())));
+		}
+	}
+	SnapVector<bug_message *> *bugs = execution->get_bugs();
+	for (unsigned int i = 0;i < bugs->size();i++)
+		found |= add_behavior(BEHAVIOR_BUG, behavior_hash(BEHAVIOR_BUG, string_hash((*bugs)[i]->msg), 0));
+	return found;
+}
+
 /** @brief Print execution stats */
 void ModelChecker::print_stats() const
 {
 	model_print("Number of complete, bug-free executions: %d\n", stats.num_complete);
 	model_print("Number of buggy executions: %d\n", stats.num_buggy_executions);
 	model_print("Total executions: %d\n", stats.num_total);
+	if (stats.num_distinct != 0)
+		model_print("Distinct executions by trace hash: %d (%d repeats, %d seen once)\n",
+								stats.num_distinct, stats.num_duplicate, stats.num_singletons);
+	if (params.saturation != 0)
+		model_print("Behaviors seen: reads-from pairs: %d, mo edges: %d, bug signatures: %d\n",
+								stats.num_behaviors[BEHAVIOR_RF], stats.num_behaviors[BEHAVIOR_MO], stats.num_behaviors[BEHAVIOR_BUG]);
+	if (stats.num_crashed != 0)
+		model_print("Executions that crashed: %d\n", stats.num_crashed);
+	if (stats.num_truncated != 0)
+		model_print("Executions truncated by their budget: %d\n", stats.num_truncated);
+	if (stats.num_spin_loops != 0)
+		model_print("Spin loops deprioritized: %d\n", stats.num_spin_loops);
+	execution->getFuzzer()->print_stats();
 }
 
 /**
@@ -273,6 +441,7 @@ void ModelChecker::print_execution(bool printbugs) const
 	if (printbugs && execution->have_bug_reports()) {
 		model_print("\n");
 		print_bugs();
+		print_rerun_hint(get_execution_number());
 	}
 
 	model_print("\n");
@@ -280,17 +449,15 @@ void ModelChecker::print_execution(bool printbugs) const
 }
 
 /**
- * Queries the model-checker for more executions to explore and, if one
- * exists, resets the model-checker state to execute a new execution.
- *
- * @return If there are more executions to explore, return true. Otherwise,
- * return false.
+ * Runs the end-of-execution bug checks, records the execution's stats and
+ * prints it if asked to.
  */
-void ModelChecker::finish_execution(bool more_executions)
+void ModelChecker::finish_execution()
 {
 	DBG();
 	/* Is this execution a feasible execution that's worth bug-checking? */
-	bool complete = (execution->is_complete_execution() ||
+	bool complete = !execution->is_truncated() &&
+									(execution->is_complete_execution() ||
 									 execution->have_bug_reports());
 
 	/* End-of-execution bug checks */
@@ -307,12 +474,35 @@ void ModelChecker::finish_execution(bool more_executions)
 		print_execution(complete);
 	else
 		clear_program_output();
+	execution->getFuzzer()->execution_finished();
 
 	execution_number ++;
 	history->set_new_exec_flag();
+}
 
-	if (more_executions)
-		reset_to_initial_state();
+/**
+ * @brief Decide whether to stop after the execution that just finished
+ * @param reason Set to why, if so
+ * @return True if no more executions should run
+ */
+bool ModelChecker::should_stop(enum stop_reason *reason) const
+{
+	int hashed = stats.num_distinct + stats.num_duplicate;
+	if (campaign_deadline != 0 && monotonic_ns() >= campaign_deadline)
+		*reason = STOP_TIME_BUDGET;
+	else if (params.saturation != 0 && stats.num_stale >= (int)params.saturation)
+		*reason = STOP_SATURATED;
+	/* The Good-Turing estimate of the chance that the next execution has a
+	 * new trace hash is the fraction of executions whose hash was seen only
+	 * once. It can't resolve chances below 1/hashed. */
+	else if (params.unseenbound > 0 && hashed * params.unseenbound >= 1 &&
+					 stats.num_singletons < hashed * params.unseenbound)
+		*reason = STOP_UNSEEN;
+	else if (execution_number - params.startexec >= params.maxexecutions)
+		*reason = STOP_MAX_EXECUTIONS;
+	else
+		return false;
+	return true;
 }
 
 /** @brief Run trace analyses on complete trace */
@@ -341,13 +531,19 @@ Thread * ModelChecker::get_thread(const ModelAction *act) const
 	return execution->get_thread(act);
 }
 
+/** @brief Free old actions once every checkthreshold actions, if enabled */
+void ModelChecker::checkCollectActions()
+{
+	if (params.traceminsize != 0 &&
+			execution->get_curr_seq_num() > checkfree) {
+		checkfree += params.checkthreshold;
+		execution->collectActions();
+	}
+}
+
 void ModelChecker::startRunExecution(Thread *old) {
 	while (true) {
-		if (params.traceminsize != 0 &&
-				execution->get_curr_seq_num() > checkfree) {
-			checkfree += params.checkthreshold;
-			execution->collectActions();
-		}
+		checkCollectActions();
 
 		curr_thread_num = 1;
 		Thread *thr = getNextThread(old);
@@ -370,7 +566,11 @@ void ModelChecker::startRunExecution(Thread *old) {
 Thread* ModelChecker::getNextThread(Thread *old)
 {
 	Thread *nextThread = nullptr;
-	for (unsigned int i = curr_thread_num;i < get_num_threads();i++) {
+	unsigned int num_threads = get_num_threads();
+	/* Threads outside the ready set can't run or change state until the
+	 * scheduler enables them again, so only visit the ready set */
+	for (int next = scheduler->next_ready(curr_thread_num);next >= 0 && (unsigned int)next < num_threads;next = scheduler->next_ready(next + 1)) {
+		unsigned int i = next;
 		thread_id_t tid = int_to_id(i);
 		Thread *thr = get_thread(tid);
 
@@ -380,15 +580,27 @@ Thread* ModelChecker::getNextThread(Thread *old)
 				nextThread = thr;
 				break;
 			}
-		} else if (thr != old && !thr->is_freed()) {
-			thr->freeResources();
+		} else if (thr != old) {
+			if (!thr->is_freed())
+				thr->freeResources();
+			scheduler->remove_ready(thr);
+			continue;
 		}
 
 		ModelAction *act = thr->get_pending();
-		if (act && execution->is_enabled(tid)){
+		if (act && !execution->is_enabled(tid)) {
+			scheduler->remove_ready(thr);
+		} else if (act) {
 			/* Don't schedule threads which should be disabled */
 			if (!execution->check_action_enabled(act)) {
-				scheduler->sleep(thr);
+				if (act->is_timed()) {
+					/* A timed lock waits in the sleep set, so that its
+					 * deadline can still wake it up */
+					scheduler->add_sleep(thr);
+				} else {
+					scheduler->sleep(thr);
+					scheduler->remove_ready(thr);
+				}
 			}
 
 			/* Allow pending relaxed/release stores or thread actions to perform first */
@@ -411,6 +623,122 @@ Thread* ModelChecker::getNextThread(Thread *old)
 	return nextThread;
 }
 
+/** @brief Print the stats of the whole run and why it stopped */
+void ModelChecker::print_final_summary(enum stop_reason reason) const
+{
+	model_print("******* Model-checking complete: *******\n");
+	if (reason == STOP_EXHAUSTED)
+		model_print("Explored every execution within the search bounds\n");
+	else if (reason == STOP_TIME_BUDGET)
+		model_print("Stopped after the time budget of %u seconds\n", params.timebudget);
+	else if (reason == STOP_SATURATED)
+		model_print("Stopped after %u executions in a row showed no new behavior\n", params.saturation);
+	else if (reason == STOP_UNSEEN)
+		model_print("Stopped with an estimated %.4f chance that an execution has a new trace hash\n",
+								(double)stats.num_singletons / (stats.num_distinct + stats.num_duplicate));
+	print_stats();
+}
+
+/**
+ * @brief Tell how to rerun an execution on its own
+ *
+ * Only the random and pos fuzzers make each execution's decisions from its
+ * seed alone; the others carry state over from earlier executions. Besides
+ * the seed, the hint repeats every option that was changed from its default
+ * and that changes the decisions, or which bugs the execution reports.
+ * @param number The execution's number
+ */
+void ModelChecker::print_rerun_hint(int number) const
+{
+	if (params.fuzzer != FUZZER_RANDOM && params.fuzzer != FUZZER_POS)
+		return;
+	struct model_params defaults;
+	param_defaults(&defaults);
+
+	model_print("Rerun this execution alone with -e %llu -j %d -x 1",
+							(unsigned long long)params.seed, number);
+	if (params.fuzzer == FUZZER_POS)
+		model_print(" -z pos");
+	if (params.batchlocal)
+		model_print(" -b");
+	if (params.stacksize != defaults.stacksize)
+		model_print(" -s %zu", params.stacksize / 1024);
+	if (params.traceminsize != defaults.traceminsize)
+		model_print(" -m %u", params.traceminsize);
+	if (params.checkthreshold != defaults.checkthreshold)
+		model_print(" -f %u", params.checkthreshold);
+	if (params.removevisible)
+		model_print(" -r");
+	if (params.maxactions != defaults.maxactions)
+		model_print(" -a %u", params.maxactions);
+	if (params.exectime != defaults.exectime)
+		model_print(" -l %u", params.exectime);
+	model_print("\n");
+}
+
+/**
+ * @brief Record how this execution's process is about to die
+ *
+ * Called from the signal handler, so only stores the details; the parent
+ * process reports them.
+ */
+void ModelChecker::set_crash(int sig, void *pc, void *addr)
+{
+	crash.signal = sig;
+	crash.pc = pc;
+	crash.addr = addr;
+}
+
+/**
+ * @brief Account for an execution whose process died
+ *
+ * Runs in the parent process, which shares the cumulative stats and the
+ * fuzzer's cross-execution state with the dead one but none of its
+ * execution state. The execution counts as buggy, and the campaign goes on
+ * unless it was the last one.
+ *
+ * @param pid The dead process
+ * @param status Its status, from waitpid()
+ * @return Whether to run another execution
+ */
+bool ModelChecker::recover_from_crash(pid_t pid, int status)
+{
+	if (WIFSIGNALED(status) && WTERMSIG(status) == crash.signal) {
+		model_print("Execution %d crashed: %s at pc %p", execution_number, strsignal(crash.signal), crash.pc);
+		if (crash.addr != NULL)
+			model_print(", address %p", crash.addr);
+		model_print("\n");
+	} else if (WIFSIGNALED(status))
+		model_print("Execution %d was killed: %s\n", execution_number, strsignal(WTERMSIG(status)));
+	else
+		model_print("Execution %d exited with status %d\n", execution_number, WEXITSTATUS(status));
+	print_rerun_hint(execution_number);
+	model_print("\n");
+	bool exhausted = !execution->getFuzzer()->execution_crashed();
+
+	/* The dead process could not clean up its output file */
+	char filename[256];
+	snprintf_(filename, sizeof(filename), "C11FuzzerTmp%d", pid);
+	unlink(filename);
+
+	stats.num_total ++;
+	stats.num_buggy_executions ++;
+	stats.num_crashed ++;
+	/* A crash is a bug, told apart from others by its signal and pc */
+	if (params.saturation != 0 &&
+			add_behavior(BEHAVIOR_BUG, behavior_hash(BEHAVIOR_BUG, status, (uintptr_t)crash.pc)))
+		stats.num_stale = 0;
+	else
+		stats.num_stale ++;
+	execution_number ++;
+
+	enum stop_reason reason = STOP_EXHAUSTED;
+	if (!exhausted && !should_stop(&reason))
+		return true;
+	print_final_summary(reason);
+	return false;
+}
+
 /* Swap back to system_context and terminate this execution */
 void ModelChecker::finishRunExecution(Thread *old)
 {
@@ -418,14 +746,19 @@ void ModelChecker::finishRunExecution(Thread *old)
 
 	/** Reset curr_thread_num to initial value for next execution. */
 	curr_thread_num = 1;
+	/** A thread picked in this execution means nothing in the next one */
+	chosen_thread = NULL;
 
-	/** If we have more executions, we won't make it past this call. */
-	finish_execution(execution_number < params.maxexecutions);
+	bool exhausted = !execution->getFuzzer()->has_more_executions();
+	finish_execution();
 
+	/** If we have more executions, we won't make it past this call. */
+	enum stop_reason reason = STOP_EXHAUSTED;
+	if (!exhausted && !should_stop(&reason))
+		reset_to_initial_state();
 
 	/** We finished the final execution.  Print stuff and exit. */
-	model_print("******* Model-checking complete: *******\n");
-	print_stats();
+	print_final_summary(reason);
 
 	/* Have the trace analyses dump their output. */
 	for (unsigned int i = 0;i < trace_analyses.size();i++)
@@ -462,6 +795,21 @@ uint64_t ModelChecker::switch_thread(ModelAction *act)
 		inspect_plugin->inspectModelAction(act);
 	}
 
+	/* No other thread can tell when a thread-local action runs, so skip
+	 * scheduling, unless another thread is owed the next step. As in
+	 * handleChosenThread(), the step names the thread to run next: this one
+	 * again after the read half of an RMW, and none after its write half. */
+	if (params.batchlocal && act != NULL &&
+			(chosen_thread == NULL || chosen_thread == old) &&
+			execution->is_thread_local_action(act)) {
+		chosen_thread = execution->take_step(act);
+		old->set_state(THREAD_RUNNING);
+		if (should_terminate_execution())
+			finishRunExecution(old);
+		checkCollectActions();
+		return old->get_return_value();
+	}
+
 	old->set_pending(act);
 
 	if (old->is_waiting_on(old))
@@ -498,6 +846,7 @@ bool ModelChecker::handleChosenThread(Thread *old)
 	if (chosen_thread->just_woken_up()) {
 		chosen_thread->set_wakeup_state(false);
 		chosen_thread->set_pending(NULL);
+		execution->getFuzzer()->pending_consumed(chosen_thread);
 		chosen_thread = NULL;
 		// Allow this thread to stash the next pending action
 		return true;
@@ -518,13 +867,24 @@ bool ModelChecker::handleChosenThread(Thread *old)
 
 void ModelChecker::startChecker() {
 	startExecution();
-	//Need to initial random number generator state to avoid resets on rollback
-	initstate(423121, random_state, sizeof(random_state));
 
 	snapshot = take_snapshot();
 
-	//reset random number generator state
-	setstate(random_state);
+	/* Every execution draws from its own stream, so that it can be rerun
+	 * without the executions before it */
+	uint64_t seed = execution_seed(params.seed, execution_number);
+	model_random_seed(seed);
+	srandom((unsigned int)seed);
+	set_crash(0, NULL, NULL);
+
+	/* The execution ends at its own time budget or the campaign's,
+	 * whichever comes first */
+	exec_deadline = campaign_deadline;
+	if (params.exectime != 0) {
+		uint64_t deadline = monotonic_ns() + (uint64_t)params.exectime * 1000000;
+		if (exec_deadline == 0 || deadline < exec_deadline)
+			exec_deadline = deadline;
+	}
 
 	install_trace_analyses(get_execution());
 	redirect_output();
@@ -538,6 +898,17 @@ bool ModelChecker::should_terminate_execution()
 		return true;
 	} else if (execution->isFinished()) {
 		return true;
+	} else if (over_budget()) {
+		execution->set_truncated();
+		return true;
 	}
 	return false;
 }
+
+/** @return Whether this execution has used up its action or time budget */
+bool ModelChecker::over_budget() const
+{
+	if (params.maxactions != 0 && execution->get_curr_seq_num() >= params.maxactions)
+		return true;
+	return exec_deadline != 0 && monotonic_ns() >= exec_deadline;
+}
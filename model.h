@@ -7,6 +7,7 @@
 
 #include <cstddef>
 #include <inttypes.h>
+#include <sys/types.h>
 
 #include "mymemory.h"
 #include "hashtable.h"
@@ -18,11 +19,43 @@
 #include "classlist.h"
 #include "snapshot-interface.h"
 
+/** @brief Kinds of behavior tracked to tell when a run has saturated */
+enum behavior_kind {
+	BEHAVIOR_RF,	/**< @brief A reads-from pair of source positions */
+	BEHAVIOR_MO,	/**< @brief A modification order edge between source positions */
+	BEHAVIOR_BUG,	/**< @brief A bug report, or a crash's signal and pc */
+	NUM_BEHAVIOR_KINDS
+};
+
 /** @brief Model checker execution stats */
 struct execution_stats {
 	int num_total;	/**< @brief Total number of executions */
 	int num_buggy_executions;	/** @brief Number of buggy executions */
 	int num_complete;	/**< @brief Number of feasible, non-buggy, complete executions */
+	int num_spin_loops;	/**< @brief Number of times a thread was found spinning */
+	int num_truncated;	/**< @brief Number of executions cut short by their budget */
+	int num_crashed;	/**< @brief Number of executions whose process died */
+	int num_distinct;	/**< @brief Number of executions with a trace hash not seen before */
+	int num_duplicate;	/**< @brief Number of executions that repeated an earlier trace hash */
+	int num_singletons;	/**< @brief Number of trace hashes seen exactly once */
+	int num_stale;	/**< @brief Executions in a row, up to the last one, with no new behavior */
+	int num_behaviors[NUM_BEHAVIOR_KINDS];	/**< @brief Distinct behaviors seen, of each kind */
+};
+
+/** @brief How an execution's process died, as seen by its signal handler */
+struct crash_report {
+	int signal;	/**< @brief The fatal signal, or 0 */
+	void *pc;	/**< @brief Program counter at the signal, if known */
+	void *addr;	/**< @brief Faulting address */
+};
+
+/** @brief Why the model checker stopped starting executions */
+enum stop_reason {
+	STOP_MAX_EXECUTIONS,	/**< @brief Ran as many executions as asked */
+	STOP_EXHAUSTED,	/**< @brief The fuzzer explored everything within its bounds */
+	STOP_TIME_BUDGET,	/**< @brief Ran out of the time budget */
+	STOP_SATURATED,	/**< @brief Executions stopped showing new behavior */
+	STOP_UNSEEN	/**< @brief New trace hashes became unlikely */
 };
 
 /** @brief The central structure for model-checking */
@@ -52,6 +85,9 @@ public:
 
 	void assert_user_bug(const char *msg);
 
+	void set_crash(int sig, void *pc, void *addr);
+	bool recover_from_crash(pid_t pid, int status);
+
 	model_params params;
 	void add_trace_analysis(TraceAnalysis *a) {     trace_analyses.push_back(a); }
 	void set_inspect_plugin(TraceAnalysis *a) {     inspect_plugin=a;       }
@@ -69,6 +105,15 @@ private:
 	ModelExecution *execution;
 	Thread * init_thread;
 
+	/** @brief Written by the signal handler of a crashing execution */
+	struct crash_report crash;
+
+	/** @brief Number of executions so far with each trace hash */
+	trace_hash_count_t * trace_hashes;
+
+	/** @brief Behaviors of all executions so far, tracked with -q */
+	behavior_set_t * behaviors;
+
 	int execution_number;
 
 	unsigned int curr_thread_num;
@@ -79,29 +124,41 @@ private:
 	void finishRunExecution(Thread *old);
 	Thread * getNextThread(Thread *old);
 	bool handleChosenThread(Thread *old);
+	void checkCollectActions();
 
 	modelclock_t checkfree;
 
+	/** @brief Monotonic time (ns) at which the campaign's time budget ends, or 0 */
+	uint64_t campaign_deadline;
+
+	/** @brief Monotonic time (ns) at which this execution is truncated, or 0 */
+	uint64_t exec_deadline;
+
 	unsigned int get_num_threads() const;
 
-	void finish_execution(bool moreexecutions);
+	void finish_execution();
 	bool should_terminate_execution();
+	bool should_stop(enum stop_reason *reason) const;
+	bool over_budget() const;
 
 	Thread * get_next_thread();
 	void reset_to_initial_state();
 
 	ModelVector<TraceAnalysis *> trace_analyses;
-	char random_state[256];
 
 	/** @bref Plugin that can inspect new actions. */
 	TraceAnalysis *inspect_plugin;
 	/** @brief The cumulative execution stats */
 	struct execution_stats stats;
 	void record_stats();
+	bool record_behaviors();
+	bool add_behavior(enum behavior_kind kind, uint64_t hash);
 	void run_trace_analyses();
 	void print_bugs() const;
 	void print_execution(bool printbugs) const;
 	void print_stats() const;
+	void print_final_summary(enum stop_reason reason) const;
+	void print_rerun_hint(int number) const;
 };
 
 extern ModelChecker *model;
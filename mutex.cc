@@ -31,6 +31,18 @@ bool mutex::try_lock()
 	return model->switch_thread(new ModelAction(ATOMIC_TRYLOCK, std::memory_order_seq_cst, this));
 }
 
+/**
+ * @brief Lock, but give up once the absolute CLOCK_REALTIME deadline abstime
+ * passes on the execution's virtual clock
+ * @return 0 if locked, ETIMEDOUT if timed out
+ */
+int mutex::timed_lock(const struct timespec *abstime)
+{
+	ModelAction *lock = new ModelAction(ATOMIC_TIMEDLOCK, std::memory_order_seq_cst, this);
+	lock->set_time(model->get_execution()->get_virtual_deadline(abstime));
+	return model->switch_thread(lock);
+}
+
 void mutex::unlock()
 {
 	model->switch_thread(new ModelAction(ATOMIC_UNLOCK, std::memory_order_seq_cst, this));
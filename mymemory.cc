@@ -74,6 +74,154 @@ void model_free(void *ptr)
 	mspace_free(sStaticSpace, ptr);
 }
 
+/**
+ * Execution-scoped region allocator.
+ *
+ * Everything in the snapshotting heap is discarded wholesale by
+ * snapshot_roll_back(), so scratch data that is only needed during an
+ * execution does not need dlmalloc's per-object bookkeeping. The region
+ * bump allocates blocks out of REGION_CHUNK_SIZE chunks taken from the
+ * snapshotting heap. Blocks form a stack: freeing the most recent block
+ * rewinds the bump pointer, and blocks freed out of order are only marked
+ * and reclaimed once everything allocated after them has been freed. The
+ * region state lives in ordinary process memory and is rolled back with
+ * the snapshotting heap.
+ */
+
+#define REGION_CHUNK_SIZE (256 * 1024)
+/** Requests larger than this bypass the region and go to the mspace */
+#define REGION_LARGE_SIZE (REGION_CHUNK_SIZE / 4)
+/** Matches the mspace alignment; both region headers are a multiple of it */
+#define REGION_ALIGN (2 * sizeof(void *))
+
+#define REGION_FREED ((size_t)1)
+#define REGION_LARGE ((size_t)2)
+#define REGION_FLAGS (REGION_FREED | REGION_LARGE)
+
+struct region_block {
+	/** @brief Payload size (a multiple of REGION_ALIGN) | flags */
+	size_t size;
+	/** @brief Previous block in the same chunk */
+	struct region_block *prev;
+};
+
+struct region_chunk {
+	struct region_chunk *prev;
+	/** @brief Most recently allocated block still in the chunk */
+	struct region_block *last;
+	char *top;
+	char *end;
+};
+
+static struct region_chunk *region_curr = NULL;
+/** @brief One emptied chunk is kept around to avoid thrashing on chunk boundaries */
+static struct region_chunk *region_spare = NULL;
+
+static struct region_chunk * region_new_chunk()
+{
+	struct region_chunk *chunk = region_spare;
+	if (chunk != NULL)
+		region_spare = NULL;
+	else
+		chunk = (struct region_chunk *)snapshot_malloc(REGION_CHUNK_SIZE);
+	chunk->prev = region_curr;
+	chunk->last = NULL;
+	chunk->top = (char *)(chunk + 1);
+	chunk->end = ((char *)chunk) + REGION_CHUNK_SIZE;
+	return chunk;
+}
+
+/** @brief Pop freed blocks off the top of the region */
+static void region_rewind()
+{
+	while (region_curr != NULL) {
+		struct region_block *last = region_curr->last;
+		while (last != NULL && (last->size & REGION_FREED)) {
+			region_curr->top = (char *)last;
+			last = last->prev;
+		}
+		region_curr->last = last;
+		if (last != NULL || region_curr->prev == NULL)
+			return;
+		/* Chunk is empty, go back to the previous one */
+		struct region_chunk *empty = region_curr;
+		region_curr = empty->prev;
+		if (region_spare == NULL)
+			region_spare = empty;
+		else
+			snapshot_free(empty);
+	}
+}
+
+/** @brief Region malloc, for scratch data that may live until rollback */
+void * region_malloc(size_t size)
+{
+	size = (size + REGION_ALIGN - 1) & ~((size_t)REGION_ALIGN - 1);
+	struct region_block *block;
+	if (size > REGION_LARGE_SIZE) {
+		block = (struct region_block *)snapshot_malloc(sizeof(struct region_block) + size);
+		block->size = size | REGION_LARGE;
+		block->prev = NULL;
+		return block + 1;
+	}
+
+	size_t needed = sizeof(struct region_block) + size;
+	if (region_curr == NULL || (size_t)(region_curr->end - region_curr->top) < needed)
+		region_curr = region_new_chunk();
+
+	block = (struct region_block *)region_curr->top;
+	block->size = size;
+	block->prev = region_curr->last;
+	region_curr->last = block;
+	region_curr->top += needed;
+	return block + 1;
+}
+
+/** @brief Region free; reclaims memory once it reaches the top of the region */
+void region_free(void *ptr)
+{
+	if (ptr == NULL)
+		return;
+	struct region_block *block = ((struct region_block *)ptr) - 1;
+	if (block->size & REGION_LARGE) {
+		snapshot_free(block);
+		return;
+	}
+	block->size |= REGION_FREED;
+	if (region_curr != NULL && block == region_curr->last)
+		region_rewind();
+}
+
+/** @brief Region realloc; grows the topmost block in place when possible */
+void * region_realloc(void *ptr, size_t size)
+{
+	if (ptr == NULL)
+		return region_malloc(size);
+	struct region_block *block = ((struct region_block *)ptr) - 1;
+	size_t oldsize = block->size & ~REGION_FLAGS;
+	size_t newsize = (size + REGION_ALIGN - 1) & ~((size_t)REGION_ALIGN - 1);
+
+	if (block->size & REGION_LARGE) {
+		if (newsize > REGION_LARGE_SIZE) {
+			block = (struct region_block *)snapshot_realloc(block, sizeof(struct region_block) + newsize);
+			block->size = newsize | REGION_LARGE;
+			return block + 1;
+		}
+	} else if (block == region_curr->last &&
+						 (size_t)(region_curr->end - (char *)ptr) >= newsize) {
+		block->size = newsize;
+		region_curr->top = ((char *)ptr) + newsize;
+		return ptr;
+	} else if (newsize <= oldsize) {
+		return ptr;
+	}
+
+	void *newptr = region_malloc(size);
+	memcpy(newptr, ptr, oldsize < newsize ? oldsize : newsize);
+	region_free(ptr);
+	return newptr;
+}
+
 /** Bootstrap allocation. Problem is that the dynamic linker calls require
  *  calloc to work and calloc requires the dynamic linker to work. */
 
@@ -47,6 +47,26 @@
 		return p; \
 	}
 
+/** SNAPSHOTSLABALLOC declares the allocators for a fixed-size, frequently
+ *	allocated class to carve its objects out of slabs in the snapshotting
+ *	heap.  Arrays still go directly to the snapshotting heap. */
+#define SNAPSHOTSLABALLOC(type) \
+	void * operator new(size_t size) { \
+		return SnapshotSlab<sizeof(type)>::allocate(); \
+	} \
+	void operator delete(void *p, size_t size) { \
+		SnapshotSlab<sizeof(type)>::deallocate(p); \
+	} \
+	void * operator new[](size_t size) { \
+		return snapshot_malloc(size); \
+	} \
+	void operator delete[](void *p, size_t size) { \
+		snapshot_free(p); \
+	} \
+	void * operator new(size_t size, void *p) {	/* placement new */ \
+		return p; \
+	}
+
 void *model_malloc(size_t size);
 void *model_calloc(size_t count, size_t size);
 void model_free(void *ptr);
@@ -57,9 +77,72 @@ void * snapshot_calloc(size_t count, size_t size);
 void * snapshot_realloc(void *ptr, size_t size);
 void snapshot_free(void *ptr);
 
+void * region_malloc(size_t size);
+void * region_realloc(void *ptr, size_t size);
+void region_free(void *ptr);
+
 typedef void * mspace;
 extern mspace sStaticSpace;
 
+/** Size of each chunk requested from the snapshotting heap by a slab */
+#define SLAB_CHUNK_SIZE (64 * 1024)
+
+/**
+ * @brief Free-list allocator for fixed-size objects in the snapshotting heap
+ *
+ * Objects of the same (rounded) size share one slab. New objects are bump
+ * allocated from SLAB_CHUNK_SIZE chunks so that objects created one after
+ * another are contiguous in memory, and freed objects are pushed onto a free
+ * list for O(1) reuse. Chunks are never handed back to the mspace. The slab
+ * state lives in ordinary process memory, so it is rolled back together with
+ * the snapshotting heap it points into.
+ *
+ * @tparam objsize The size of the objects served by this slab
+ */
+template<size_t objsize>
+class SnapshotSlab {
+public:
+	static void * allocate() {
+		void *obj = freelist;
+		if (obj != NULL) {
+			freelist = *(void **)obj;
+			return obj;
+		}
+		if (bump == end)
+			refill();
+		obj = bump;
+		bump += slotsize;
+		return obj;
+	}
+
+	static void deallocate(void *obj) {
+		*(void **)obj = freelist;
+		freelist = obj;
+	}
+
+private:
+	/** Slot size: objsize rounded up to pointer alignment */
+	static const size_t slotsize = (objsize < sizeof(void *)) ? sizeof(void *) :
+																 ((objsize + sizeof(void *) - 1) & ~(sizeof(void *) - 1));
+	static const size_t slotsperchunk = SLAB_CHUNK_SIZE / slotsize;
+
+	static void refill() {
+		bump = (char *)snapshot_malloc(slotsperchunk * slotsize);
+		end = bump + slotsperchunk * slotsize;
+	}
+
+	static void *freelist;
+	static char *bump;
+	static char *end;
+};
+
+template<size_t objsize>
+void * SnapshotSlab<objsize>::freelist = NULL;
+template<size_t objsize>
+char * SnapshotSlab<objsize>::bump = NULL;
+template<size_t objsize>
+char * SnapshotSlab<objsize>::end = NULL;
+
 void * Thread_malloc(size_t size);
 void Thread_free(void *ptr);
 
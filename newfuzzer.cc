@@ -10,6 +10,7 @@
 #include "model.h"
 #include "schedule.h"
 #include "execution.h"
+#include "prng.h"
 
 NewFuzzer::NewFuzzer() :
 	thrd_last_read_act(),
@@ -31,9 +32,9 @@ void NewFuzzer::register_engine(ModelChecker *_model, ModelExecution *execution)
 	this->execution = execution;
 }
 
-int NewFuzzer::selectWrite(ModelAction *read, SnapVector<ModelAction *> * rf_set)
+int NewFuzzer::selectWrite(ModelAction *read, scratch_action_vector_t * rf_set)
 {
-	return random() % rf_set->size();
+	return model_random() % rf_set->size();
 
 	thread_id_t tid = read->get_tid();
 	int thread_id = id_to_int(tid);
@@ -105,7 +106,7 @@ int NewFuzzer::selectWrite(ModelAction *read, SnapVector<ModelAction *> * rf_set
 		ASSERT(selected_branch);
 	}
 
-	int random_index = random() % rf_set->size();
+	int random_index = model_random() % rf_set->size();
 
 	return random_index;
 }
@@ -114,7 +115,7 @@ int NewFuzzer::selectWrite(ModelAction *read, SnapVector<ModelAction *> * rf_set
  * @return False if no child matches read_inst
  */
 bool NewFuzzer::check_branch_inst(Predicate * curr_pred, FuncInst * read_inst,
-																	SnapVector<ModelAction *> * rf_set)
+																	scratch_action_vector_t * rf_set)
 {
 	available_branches_tmp_storage.clear();
 
@@ -188,7 +189,7 @@ int NewFuzzer::choose_branch_index(SnapVector<Predicate *> * branches)
 		weights.push_back(weight);
 	}
 
-	double prob = (double) random() / RAND_MAX;
+	double prob = (double) model_random() / RAND_MAX;
 	double prob_sum = 0;
 	int index = 0;
 
@@ -218,7 +219,7 @@ Predicate * NewFuzzer::get_selected_child_branch(thread_id_t tid)
  *
  * @return true if rf_set is pruned
  */
-bool NewFuzzer::prune_writes(thread_id_t tid, Predicate * pred, SnapVector<ModelAction *> * rf_set)
+bool NewFuzzer::prune_writes(thread_id_t tid, Predicate * pred, scratch_action_vector_t * rf_set)
 {
 	if (pred == NULL)
 		return false;
@@ -338,14 +339,14 @@ bool NewFuzzer::has_paused_threads()
 	return paused_thread_list.size() != 0;
 }
 
-Thread * NewFuzzer::selectThread(int * threadlist, int numthreads)
+Thread * NewFuzzer::selectThread(ThreadSet * threads)
 {
-	if (numthreads == 0 && has_paused_threads()) {
-		wake_up_paused_threads(threadlist, &numthreads);
-		//model_print("list size: %d, active t id: %d\n", numthreads, threadlist[0]);
+	if (threads->size() == 0 && has_paused_threads()) {
+		/* Waking a paused thread enables it, adding it to threads */
+		wake_up_paused_threads();
 	}
-	int random_index = random() % numthreads;
-	int thread = threadlist[random_index];
+	int random_index = model_random() % threads->size();
+	int thread = threads->select(random_index);
 	thread_id_t curr_tid = int_to_id(thread);
 	return execution->get_thread(curr_tid);
 }
@@ -353,9 +354,9 @@ Thread * NewFuzzer::selectThread(int * threadlist, int numthreads)
 /* Force waking up one of threads paused by Fuzzer, because otherwise
  * the Fuzzer is not making progress
  */
-void NewFuzzer::wake_up_paused_threads(int * threadlist, int * numthreads)
+void NewFuzzer::wake_up_paused_threads()
 {
-	int random_index = random() % paused_thread_list.size();
+	int random_index = model_random() % paused_thread_list.size();
 	Thread * thread = paused_thread_list[random_index];
 	model->getScheduler()->remove_sleep(thread);
 
@@ -369,9 +370,6 @@ void NewFuzzer::wake_up_paused_threads(int * threadlist, int * numthreads)
 	history->remove_waiting_write(tid);
 	history->remove_waiting_thread(tid);
 
-	threadlist[*numthreads] = tid;
-	(*numthreads)++;
-
 /*--
         Predicate * selected_branch = get_selected_child_branch(tid);
         update_predicate_score(selected_branch, SLEEP_FAIL_TYPE3);
@@ -24,14 +24,11 @@ struct node_dist_info {
 class NewFuzzer : public Fuzzer {
 public:
 	NewFuzzer();
-	int selectWrite(ModelAction *read, SnapVector<ModelAction *>* rf_set);
+	int selectWrite(ModelAction *read, scratch_action_vector_t * rf_set);
 	bool has_paused_threads();
 	void notify_paused_thread(Thread * thread);
 
-	Thread * selectThread(int * threadlist, int numthreads);
-	Thread * selectNotify(simple_action_list_t * waiters);
-	bool shouldSleep(const ModelAction * sleep);
-	bool shouldWake(const ModelAction * sleep);
+	Thread * selectThread(ThreadSet * threads);
 	bool shouldWait(const ModelAction * wait);
 
 	void register_engine(ModelChecker * model, ModelExecution * execution);
@@ -49,9 +46,9 @@ private:
 	SnapVector<Predicate *> thrd_selected_child_branch;
 	SnapVector< SnapVector<ModelAction *> *> thrd_pruned_writes;
 
-	bool check_branch_inst(Predicate * curr_pred, FuncInst * read_inst, SnapVector<ModelAction *> * rf_set);
+	bool check_branch_inst(Predicate * curr_pred, FuncInst * read_inst, scratch_action_vector_t * rf_set);
 	Predicate * selectBranch(thread_id_t tid, Predicate * curr_pred, FuncInst * read_inst);
-	bool prune_writes(thread_id_t tid, Predicate * pred, SnapVector<ModelAction *> * rf_set);
+	bool prune_writes(thread_id_t tid, Predicate * pred, scratch_action_vector_t * rf_set);
 	int choose_branch_index(SnapVector<Predicate *> * branches);
 
 	/* The set of Threads put to sleep by NewFuzzer because no writes in rf_set satisfies the selected predicate. Only used by selectWrite.
@@ -62,7 +59,7 @@ private:
 	SnapVector<struct node_dist_info> dist_info_vec;	//--
 
 	void conditional_sleep(Thread * thread);	//--
-	void wake_up_paused_threads(int * threadlist, int * numthreads);	//--
+	void wake_up_paused_threads();	//--
 
 	bool find_threads(ModelAction * pending_read);	//--
 };
@@ -1,6 +1,15 @@
 #ifndef __PARAMS_H__
 #define __PARAMS_H__
 
+/** @brief Which Fuzzer picks the next thread to run */
+enum fuzzer_type {
+	FUZZER_RANDOM,
+	FUZZER_PCT,
+	FUZZER_POS,
+	FUZZER_DPOR,
+	FUZZER_COVERAGE
+};
+
 /**
  * Model checker parameter structure. Holds run-time configuration options for
  * the model checker.
@@ -11,6 +20,52 @@ struct model_params {
 	modelclock_t traceminsize;
 	modelclock_t checkthreshold;
 	bool removevisible;
+	bool batchlocal;
+
+	/** @brief Size of each thread stack, in bytes */
+	size_t stacksize;
+
+	/** @brief Pages at the top of a thread stack to fault in up front */
+	unsigned int stackprefault;
+
+	enum fuzzer_type fuzzer;
+
+	/** @brief Bug depth targeted by the PCT fuzzer */
+	unsigned int pctdepth;
+
+	/** @brief Preemptions allowed per execution by the dpor fuzzer (-1 = any) */
+	int preemptionbound;
+
+	/** @brief Decisions per execution that the dpor fuzzer explores */
+	unsigned int depthbound;
+
+	/** @brief Save buggy executions' decisions to files with this prefix */
+	const char *recordprefix;
+
+	/** @brief Replay file whose decisions the first execution follows */
+	const char *replayfile;
+
+	/** @brief Seed of the campaign; each execution's seed derives from it */
+	uint64_t seed;
+
+	/** @brief Number of the first execution */
+	int startexec;
+
+	/** @brief Actions after which an execution is truncated (0 = no bound) */
+	modelclock_t maxactions;
+
+	/** @brief Milliseconds after which an execution is truncated (0 = no bound) */
+	unsigned int exectime;
+
+	/** @brief Seconds after which no further execution starts (0 = no bound) */
+	unsigned int timebudget;
+
+	/** @brief Stop after this many executions in a row show no new behavior (0 = never) */
+	unsigned int saturation;
+
+	/** @brief Stop once the Good-Turing estimate of the chance that an
+	 *  execution has a new trace hash falls below this (0 = never) */
+	double unseenbound;
 
 	/** @brief Verbosity (0 = quiet; 1 = noisy; 2 = noisier) */
 	int verbose;
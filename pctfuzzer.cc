@@ -0,0 +1,83 @@
+#include "pctfuzzer.h"
+#include <stdlib.h>
+#include "prng.h"
+#include "threads-model.h"
+#include "model.h"
+#include "execution.h"
+
+PCTFuzzer::PCTFuzzer(unsigned int depth) :
+	execution(NULL),
+	depth(depth > 0 ? depth : 1),
+	steps(0),
+	horizon(0),
+	maxsteps((unsigned int *)model_calloc(1, sizeof(unsigned int))),
+	change_points(),
+	priorities()
+{
+	/* Grows to the longest execution seen so far */
+	*maxsteps = 1;
+}
+
+void PCTFuzzer::register_engine(ModelChecker *_model, ModelExecution *execution)
+{
+	this->execution = execution;
+}
+
+/**
+ * @brief Sample this execution's change points
+ *
+ * Called at the first scheduling step of each execution; every execution
+ * starts from the fuzzer state at the snapshot, so nothing carries over
+ * except maxsteps.
+ */
+void PCTFuzzer::start_execution()
+{
+	horizon = *maxsteps;
+	change_points.clear();
+	for (unsigned int i = 1;i < depth;i++)
+		change_points.push_back(1 + model_random() % horizon);
+	priorities.clear();
+}
+
+/**
+ * @brief Get a thread's priority, assigning a random one on first sight
+ *
+ * Initial priorities are all above depth, so that the lowered priorities
+ * 1..depth-1 rank below every thread that hasn't hit a change point.
+ */
+int64_t PCTFuzzer::get_priority(int tid)
+{
+	if ((unsigned int)tid >= priorities.size())
+		priorities.resize(tid + 1);
+	if (priorities[tid] == 0)
+		priorities[tid] = depth + 1 + (int64_t)model_random();
+	return priorities[tid];
+}
+
+Thread * PCTFuzzer::selectThread(ThreadSet * threads)
+{
+	if (steps == 0)
+		start_execution();
+	steps++;
+	if (steps > *maxsteps)
+		*maxsteps = steps;
+	if (steps > horizon)
+		return Fuzzer::selectThread(threads);
+
+	int best = -1;
+	int64_t bestpriority = 0;
+	for (int tid = threads->next(0);tid >= 0;tid = threads->next(tid + 1)) {
+		int64_t priority = get_priority(tid);
+		if (best < 0 || priority > bestpriority) {
+			best = tid;
+			bestpriority = priority;
+		}
+	}
+
+	for (unsigned int i = 0;i < change_points.size();i++) {
+		if (change_points[i] == steps)
+			priorities[best] = i + 1;
+	}
+
+	return execution->get_thread(int_to_id(best));
+}
@@ -0,0 +1,58 @@
+#ifndef __PCTFUZZER_H__
+#define __PCTFUZZER_H__
+
+#include "fuzzer.h"
+#include "classlist.h"
+#include "mymemory.h"
+#include "stl-model.h"
+
+/**
+ * @brief Probabilistic concurrency testing (PCT) thread selection
+ *
+ * Each thread gets a random priority when first seen, and the highest
+ * priority enabled thread always runs. At d-1 change points, sampled
+ * uniformly over the expected number of scheduling steps, the thread that
+ * just ran drops below every initial priority. A bug of depth d is found
+ * with probability at least 1/(n k^(d-1)) per execution.
+ *
+ * Strict priorities starve a spinning thread's peers, so past the expected
+ * length the choice falls back to uniform random.
+ */
+class PCTFuzzer : public Fuzzer {
+public:
+	PCTFuzzer(unsigned int depth);
+	Thread * selectThread(ThreadSet * threads);
+	void register_engine(ModelChecker * model, ModelExecution * execution);
+
+	SNAPSHOTALLOC
+private:
+	void start_execution();
+	int64_t get_priority(int tid);
+
+	ModelExecution * execution;
+
+	/** @brief Bug depth; there are depth-1 change points */
+	unsigned int depth;
+
+	/** @brief Scheduling steps taken in this execution */
+	unsigned int steps;
+
+	/** @brief The step count this execution's change points cover */
+	unsigned int horizon;
+
+	/**
+	 * @brief Most steps seen in any execution so far
+	 *
+	 * In shared memory, so that later executions sample their change
+	 * points over the length observed by earlier ones.
+	 */
+	unsigned int *maxsteps;
+
+	/** @brief The steps after which to lower a thread's priority */
+	SnapVector<unsigned int> change_points;
+
+	/** @brief Per-thread priority; 0 if not yet assigned */
+	SnapVector<int64_t> priorities;
+};
+
+#endif	/* __PCTFUZZER_H__ */
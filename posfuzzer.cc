@@ -0,0 +1,87 @@
+#include "posfuzzer.h"
+#include <stdlib.h>
+#include "prng.h"
+#include "threads-model.h"
+#include "model.h"
+#include "execution.h"
+#include "action.h"
+
+POSFuzzer::POSFuzzer() :
+	execution(NULL),
+	priorities(),
+	prioritized()
+{
+}
+
+void POSFuzzer::register_engine(ModelChecker *_model, ModelExecution *execution)
+{
+	this->execution = execution;
+}
+
+/**
+ * @brief Get the priority of a thread's pending action
+ *
+ * A new pending action draws a fresh random priority. Actions are recognized
+ * by address only while they are pending; see pending_consumed().
+ */
+int64_t POSFuzzer::get_priority(int tid, ModelAction *pending)
+{
+	if ((unsigned int)tid >= priorities.size()) {
+		priorities.resize(tid + 1);
+		prioritized.resize(tid + 1);
+	}
+	if (prioritized[tid] != pending) {
+		prioritized[tid] = pending;
+		priorities[tid] = model_random();
+	}
+	return priorities[tid];
+}
+
+/** @return Whether two actions touch the same location and one writes it */
+bool POSFuzzer::conflicts(const ModelAction *a, const ModelAction *b) const
+{
+	return a->get_location() == b->get_location() &&
+				 (a->is_write() || b->is_write());
+}
+
+Thread * POSFuzzer::selectThread(ThreadSet * threads)
+{
+	int best = -1;
+	int64_t bestpriority = 0;
+	for (int tid = threads->next(0);tid >= 0;tid = threads->next(tid + 1)) {
+		Thread *thr = execution->get_thread(int_to_id(tid));
+		int64_t priority = get_priority(tid, thr->get_pending());
+		if (best < 0 || priority > bestpriority) {
+			best = tid;
+			bestpriority = priority;
+		}
+	}
+
+	/* Racing actions get new priorities; independent ones keep theirs */
+	Thread *chosen = execution->get_thread(int_to_id(best));
+	ModelAction *act = chosen->get_pending();
+	if (act != NULL) {
+		for (int tid = threads->next(0);tid >= 0;tid = threads->next(tid + 1)) {
+			if (tid == best)
+				continue;
+			ModelAction *other = execution->get_thread(int_to_id(tid))->get_pending();
+			if (other != NULL && conflicts(act, other))
+				priorities[tid] = model_random();
+		}
+	}
+
+	return chosen;
+}
+
+/**
+ * @brief Forget a thread's priority once its pending action is gone
+ *
+ * Whether the action ran or was dropped, its memory may be reused for the
+ * thread's next action, which must draw a priority of its own.
+ */
+void POSFuzzer::pending_consumed(Thread *thread)
+{
+	int tid = id_to_int(thread->get_id());
+	if ((unsigned int)tid < prioritized.size())
+		prioritized[tid] = NULL;
+}
@@ -0,0 +1,41 @@
+#ifndef __POSFUZZER_H__
+#define __POSFUZZER_H__
+
+#include "fuzzer.h"
+#include "classlist.h"
+#include "mymemory.h"
+#include "stl-model.h"
+
+/**
+ * @brief Partial order sampling (POS) thread selection
+ *
+ * Every pending action gets a random priority, and the thread whose pending
+ * action has the highest priority runs. Once an action is chosen, only the
+ * pending actions that conflict with it (same location, at least one write)
+ * draw new priorities; the relative order of independent actions is left
+ * alone, so interleavings that only reorder commuting actions are not
+ * resampled as often as under uniform random choice.
+ */
+class POSFuzzer : public Fuzzer {
+public:
+	POSFuzzer();
+	Thread * selectThread(ThreadSet * threads);
+	void pending_consumed(Thread *thread);
+	void register_engine(ModelChecker * model, ModelExecution * execution);
+
+	SNAPSHOTALLOC
+private:
+	int64_t get_priority(int tid, ModelAction *pending);
+	bool conflicts(const ModelAction *a, const ModelAction *b) const;
+
+	ModelExecution * execution;
+
+	/** @brief Per-thread priority of its pending action */
+	SnapVector<int64_t> priorities;
+
+	/** @brief The pending action each priority was drawn for, or NULL once
+	 *  it is consumed */
+	SnapVector<ModelAction *> prioritized;
+};
+
+#endif	/* __POSFUZZER_H__ */
@@ -0,0 +1,53 @@
+#include "prng.h"
+
+/**
+ * State of the xoshiro256** generator. It lives in private memory: every
+ * execution reseeds it, so nothing depends on earlier executions.
+ */
+static uint64_t prng_state[4];
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+/** @brief One step of splitmix64, used to expand seeds */
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/** @return The seed of one execution of a campaign */
+uint64_t execution_seed(uint64_t campaign_seed, int execution_number)
+{
+	uint64_t x = campaign_seed;
+	uint64_t h = splitmix64(&x);
+	x = h ^ (uint64_t)(unsigned int)execution_number;
+	return splitmix64(&x);
+}
+
+void model_random_seed(uint64_t seed)
+{
+	for (int i = 0;i < 4;i++)
+		prng_state[i] = splitmix64(&seed);
+}
+
+/**
+ * @brief A drop-in replacement for random()
+ * @return A pseudo-random number in [0, 2^31)
+ */
+long model_random()
+{
+	uint64_t result = rotl(prng_state[1] * 5, 7) * 9;
+	uint64_t t = prng_state[1] << 17;
+	prng_state[2] ^= prng_state[0];
+	prng_state[3] ^= prng_state[1];
+	prng_state[1] ^= prng_state[2];
+	prng_state[0] ^= prng_state[3];
+	prng_state[2] ^= t;
+	prng_state[3] = rotl(prng_state[3], 45);
+	return (long)(result >> 33);
+}
@@ -0,0 +1,14 @@
+/** @file prng.h
+ *  @brief Pseudo-random numbers for the fuzzers.
+ */
+
+#ifndef __PRNG_H__
+#define __PRNG_H__
+
+#include <stdint.h>
+
+uint64_t execution_seed(uint64_t campaign_seed, int execution_number);
+void model_random_seed(uint64_t seed);
+long model_random();
+
+#endif	/* __PRNG_H__ */
@@ -117,7 +117,7 @@ int pthread_mutex_unlock(pthread_mutex_t *p_mutex) {
 
 int pthread_mutex_timedlock (pthread_mutex_t *__restrict p_mutex,
 														 const struct timespec *__restrict abstime) {
-// timedlock just gives the option of giving up the lock, so return and let the scheduler decide which thread goes next
+// timedlock blocks like lock, but gives up once the execution's virtual clock passes the deadline
 	createModelIfNotExist();
 	ModelExecution *execution = model->get_execution();
 
@@ -130,10 +130,8 @@ int pthread_mutex_timedlock (pthread_mutex_t *__restrict p_mutex,
 
 	cdsc::snapmutex *m = execution->getMutexMap()->get(p_mutex);
 
-	if (m != NULL) {
-		m->lock();
-		return 0;
-	}
+	if (m != NULL)
+		return m->timed_lock(abstime);
 
 	return 1;
 }
@@ -183,11 +181,7 @@ int pthread_cond_timedwait(pthread_cond_t *p_cond,
 	cdsc::snapcondition_variable *v = execution->getCondMap()->get(p_cond);
 	cdsc::snapmutex *m = execution->getMutexMap()->get(p_mutex);
 
-	model->switch_thread(new ModelAction(ATOMIC_TIMEDWAIT, std::memory_order_seq_cst, v, (uint64_t) m));
-	m->lock();
-
-	// model_print("Timed_wait is called\n");
-	return 0;
+	return v->timed_wait(*m, abstime);
 }
 
 int pthread_cond_signal(pthread_cond_t *p_cond) {
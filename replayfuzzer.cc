@@ -0,0 +1,246 @@
+#include "replayfuzzer.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "threads-model.h"
+#include "model.h"
+#include "execution.h"
+#include "action.h"
+
+static const char replay_magic[4] = { 'C', '1', '1', 'R' };
+
+static const char * const replay_kind_names[] = {
+	"thread", "write", "notify", "wait", "sleep", "wake"
+};
+
+ReplayFuzzer::ReplayFuzzer(Fuzzer *fuzzer, const char *recordprefix, const char *replayfile) :
+	fuzzer(fuzzer),
+	execution(NULL),
+	recordprefix(recordprefix),
+	replaylog(NULL),
+	replaylength(0),
+	replaypos(0),
+	log(new ModelVector<uint8_t>())
+{
+	if (replayfile == NULL)
+		return;
+
+	int fd = open(replayfile, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		model_print("Cannot open replay file %s\n", replayfile);
+		exit(EXIT_FAILURE);
+	}
+	replaylog = (uint8_t *)model_malloc(st.st_size + 1);
+	ssize_t length = 0;
+	while (length < st.st_size) {
+		ssize_t n = read(fd, replaylog + length, st.st_size - length);
+		if (n <= 0)
+			break;
+		length += n;
+	}
+	close(fd);
+	if (length < (ssize_t)sizeof(replay_magic) || memcmp(replaylog, replay_magic, sizeof(replay_magic)) != 0) {
+		model_print("%s is not a replay file\n", replayfile);
+		exit(EXIT_FAILURE);
+	}
+	replaylength = length;
+	replaypos = sizeof(replay_magic);
+}
+
+ReplayFuzzer::~ReplayFuzzer()
+{
+	delete fuzzer;
+}
+
+void ReplayFuzzer::register_engine(ModelChecker *model, ModelExecution *execution)
+{
+	this->execution = execution;
+	fuzzer->register_engine(model, execution);
+}
+
+/**
+ * @brief Read the next recorded decision
+ * @param kind The decision being made
+ * @param value Set to the recorded value
+ * @return False if there is no recorded decision of this kind to follow
+ */
+bool ReplayFuzzer::replay(replay_kind kind, unsigned int *value)
+{
+	if (replaypos >= replaylength)
+		return false;
+	if (replaylog[replaypos] != kind) {
+		mismatch(kind);
+		return false;
+	}
+
+	unsigned int pos = replaypos + 1, shift = 0;
+	*value = 0;
+	while (pos < replaylength) {
+		uint8_t byte = replaylog[pos++];
+		*value |= (unsigned int)(byte & 0x7f) << shift;
+		shift += 7;
+		if (!(byte & 0x80)) {
+			replaypos = pos;
+			return true;
+		}
+	}
+	mismatch(kind);
+	return false;
+}
+
+/** @brief Give up on a replay that the execution no longer follows */
+void ReplayFuzzer::mismatch(replay_kind kind)
+{
+	model_print("Replay diverged: execution made a %s decision at offset %u\n",
+							replay_kind_names[kind], replaypos);
+	replaypos = replaylength;
+}
+
+void ReplayFuzzer::record(replay_kind kind, unsigned int value)
+{
+	if (recordprefix == NULL)
+		return;
+	log->push_back(kind);
+	while (value >= 0x80) {
+		log->push_back((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	log->push_back(value);
+}
+
+Thread * ReplayFuzzer::selectThread(ThreadSet * threads)
+{
+	unsigned int tid;
+	bool replayed = replay(REPLAY_THREAD, &tid);
+	if (replayed && !threads->contains(tid)) {
+		mismatch(REPLAY_THREAD);
+		replayed = false;
+	}
+	Thread *thread = replayed ? execution->get_thread(int_to_id(tid)) : fuzzer->selectThread(threads);
+	record(REPLAY_THREAD, id_to_int(thread->get_id()));
+	return thread;
+}
+
+int ReplayFuzzer::selectWrite(ModelAction *read, scratch_action_vector_t * rf_set)
+{
+	unsigned int index;
+	bool replayed = replay(REPLAY_WRITE, &index);
+	if (replayed && index >= rf_set->size()) {
+		mismatch(REPLAY_WRITE);
+		replayed = false;
+	}
+	if (!replayed)
+		index = fuzzer->selectWrite(read, rf_set);
+	record(REPLAY_WRITE, index);
+	return index;
+}
+
+Thread * ReplayFuzzer::selectNotify(simple_action_list_t * waiters)
+{
+	unsigned int tid;
+	Thread *thread = NULL;
+	if (replay(REPLAY_NOTIFY, &tid)) {
+		for (sllnode<ModelAction*> * it = waiters->begin();it != NULL;it = it->getNext()) {
+			if ((unsigned int)id_to_int(it->getVal()->get_tid()) == tid) {
+				thread = model->get_thread(it->getVal());
+				waiters->erase(it);
+				break;
+			}
+		}
+		if (thread == NULL)
+			mismatch(REPLAY_NOTIFY);
+	}
+	if (thread == NULL)
+		thread = fuzzer->selectNotify(waiters);
+	record(REPLAY_NOTIFY, id_to_int(thread->get_id()));
+	return thread;
+}
+
+bool ReplayFuzzer::shouldSleep(const ModelAction *sleep)
+{
+	unsigned int value;
+	bool result = replay(REPLAY_SLEEP, &value) ? value : fuzzer->shouldSleep(sleep);
+	record(REPLAY_SLEEP, result);
+	return result;
+}
+
+bool ReplayFuzzer::shouldWake(const ModelAction *sleep)
+{
+	unsigned int value;
+	bool result = replay(REPLAY_WAKE, &value) ? value : fuzzer->shouldWake(sleep);
+	record(REPLAY_WAKE, result);
+	return result;
+}
+
+bool ReplayFuzzer::shouldWait(const ModelAction *wait)
+{
+	unsigned int value;
+	bool result = replay(REPLAY_WAIT, &value) ? value : fuzzer->shouldWait(wait);
+	record(REPLAY_WAIT, result);
+	return result;
+}
+
+void ReplayFuzzer::pending_consumed(Thread *thread)
+{
+	fuzzer->pending_consumed(thread);
+}
+
+bool ReplayFuzzer::has_paused_threads()
+{
+	return fuzzer->has_paused_threads();
+}
+
+/** @brief Save this execution's log as PREFIX-<execution number>.replay */
+void ReplayFuzzer::write_log()
+{
+	char filename[1024];
+	int number = model->get_execution_number();
+	snprintf_(filename, sizeof(filename), "%s-%d.replay", recordprefix, number);
+	int fd = open(filename, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	bool ok = fd >= 0 && write(fd, replay_magic, sizeof(replay_magic)) == sizeof(replay_magic);
+	for (unsigned int i = 0;ok && i < log->size();) {
+		uint8_t buf[4096];
+		unsigned int n = 0;
+		while (n < sizeof(buf) && i < log->size())
+			buf[n++] = (*log)[i++];
+		ok = write(fd, buf, n) == (ssize_t)n;
+	}
+	if (fd >= 0)
+		close(fd);
+	if (ok)
+		model_print("Decisions of execution %d saved; replay with -y %s\n", number, filename);
+	else
+		model_print("Could not save the decisions of execution %d to %s\n", number, filename);
+}
+
+bool ReplayFuzzer::has_more_executions()
+{
+	return fuzzer->has_more_executions();
+}
+
+/** @brief Save the decisions of a buggy execution, however its bugs were found */
+void ReplayFuzzer::execution_finished()
+{
+	if (recordprefix != NULL) {
+		if (execution->have_bug_reports())
+			write_log();
+		log->clear();
+	}
+	fuzzer->execution_finished();
+}
+
+/** @brief A crash is a bug, so save the dead execution's decisions */
+bool ReplayFuzzer::execution_crashed()
+{
+	if (recordprefix != NULL) {
+		write_log();
+		log->clear();
+	}
+	return fuzzer->execution_crashed();
+}
+
+void ReplayFuzzer::print_stats()
+{
+	fuzzer->print_stats();
+}
@@ -0,0 +1,74 @@
+#ifndef __REPLAYFUZZER_H__
+#define __REPLAYFUZZER_H__
+
+#include "fuzzer.h"
+#include "classlist.h"
+#include "mymemory.h"
+#include "stl-model.h"
+
+/** @brief The fuzzer decisions that a replay file records */
+enum replay_kind {
+	REPLAY_THREAD,
+	REPLAY_WRITE,
+	REPLAY_NOTIFY,
+	REPLAY_WAIT,
+	REPLAY_SLEEP,
+	REPLAY_WAKE
+};
+
+/**
+ * @brief Records or replays the decisions of another Fuzzer
+ *
+ * When recording, every decision of each execution is logged, and the log
+ * of each buggy execution is written to a file. When replaying, the
+ * decisions are read back from such a file and forced, so that the first
+ * execution follows the recorded one. Decisions past the end of the file,
+ * or that no longer fit the execution, are left to the wrapped Fuzzer.
+ *
+ * A replay file is the four bytes "C11R" followed by one record per
+ * decision: a kind byte and the decision's value as an LEB128 varint.
+ * Thread and notify decisions store a thread id, reads-from decisions an
+ * index into the candidate writes, and the rest 0 or 1.
+ */
+class ReplayFuzzer : public Fuzzer {
+public:
+	ReplayFuzzer(Fuzzer *fuzzer, const char *recordprefix, const char *replayfile);
+	~ReplayFuzzer();
+	int selectWrite(ModelAction *read, scratch_action_vector_t * rf_set);
+	bool has_paused_threads();
+	Thread * selectThread(ThreadSet * threads);
+	Thread * selectNotify(simple_action_list_t * waiters);
+	bool shouldSleep(const ModelAction *sleep);
+	bool shouldWake(const ModelAction *sleep);
+	bool shouldWait(const ModelAction *wait);
+	void pending_consumed(Thread *thread);
+	bool has_more_executions();
+	void execution_finished();
+	bool execution_crashed();
+	void print_stats();
+	void register_engine(ModelChecker * model, ModelExecution * execution);
+
+	SNAPSHOTALLOC
+private:
+	bool replay(replay_kind kind, unsigned int *value);
+	void record(replay_kind kind, unsigned int value);
+	void mismatch(replay_kind kind);
+	void write_log();
+
+	Fuzzer * fuzzer;
+	ModelExecution * execution;
+	const char *recordprefix;
+
+	/** @brief The file being replayed, in the non-snapshotting heap */
+	uint8_t *replaylog;
+	unsigned int replaylength;
+
+	/** @brief Offset of the next record to replay */
+	unsigned int replaypos;
+
+	/** @brief This execution's log, in replay file format; in the
+	 *  non-snapshotting heap, so that it outlives a crashed execution */
+	ModelVector<uint8_t> * log;
+};
+
+#endif	/* __REPLAYFUZZER_H__ */
@@ -26,6 +26,9 @@ void enabled_type_to_string(enabled_type_t e, char *str)
 	case THREAD_SLEEP_SET:
 		res = "sleep";
 		break;
+	case THREAD_SPINNING:
+		res = "spinning";
+		break;
 	default:
 		ASSERT(0);
 		res = NULL;
@@ -40,6 +43,10 @@ Scheduler::Scheduler() :
 	enabled(NULL),
 	enabled_len(0),
 	curr_thread_index(0),
+	enabled_set(),
+	sleep_set(),
+	spin_set(),
+	ready(),
 	current(NULL)
 {
 }
@@ -66,13 +73,40 @@ void Scheduler::set_enabled(Thread *t, enabled_type_t enabled_status) {
 		enabled_len = threadid + 1;
 	}
 	enabled[threadid] = enabled_status;
+
+	if (enabled_status == THREAD_ENABLED)
+		enabled_set.add(threadid);
+	else
+		enabled_set.remove(threadid);
+	if (enabled_status == THREAD_SLEEP_SET)
+		sleep_set.add(threadid);
+	else
+		sleep_set.remove(threadid);
+	if (enabled_status == THREAD_SPINNING)
+		spin_set.add(threadid);
+	else
+		spin_set.remove(threadid);
+	if (enabled_status != THREAD_DISABLED)
+		ready.add(threadid);
+}
+
+/**
+ * @brief Drop a Thread from the ready set
+ *
+ * Called once a Thread is found to be freed, or disabled with a pending
+ * action; it rejoins the ready set when it is next enabled.
+ * @param t The Thread to drop
+ */
+void Scheduler::remove_ready(Thread *t)
+{
+	ready.remove(id_to_int(t->get_id()));
 }
 
 /**
  * @brief Check if a Thread is currently enabled
  *
- * Check if a Thread is currently enabled. "Enabled" includes both
- * THREAD_ENABLED and THREAD_SLEEP_SET.
+ * Check if a Thread is currently enabled. "Enabled" includes
+ * THREAD_ENABLED, THREAD_SLEEP_SET and THREAD_SPINNING.
  * @param t The Thread to check
  * @return True if the Thread is currently enabled
  */
@@ -84,8 +118,8 @@ bool Scheduler::is_enabled(const Thread *t) const
 /**
  * @brief Check if a Thread is currently enabled
  *
- * Check if a Thread is currently enabled. "Enabled" includes both
- * THREAD_ENABLED and THREAD_SLEEP_SET.
+ * Check if a Thread is currently enabled. "Enabled" includes
+ * THREAD_ENABLED, THREAD_SLEEP_SET and THREAD_SPINNING.
  * @param tid The ID of the Thread to check
  * @return True if the Thread is currently enabled
  */
@@ -120,13 +154,34 @@ bool Scheduler::is_sleep_set(thread_id_t tid) const
  */
 bool Scheduler::all_threads_sleeping() const
 {
-	bool sleeping = false;
-	for (int i = 0;i < enabled_len;i++)
-		if (enabled[i] == THREAD_ENABLED)
-			return false;
-		else if (enabled[i] == THREAD_SLEEP_SET)
-			sleeping = true;
-	return sleeping;
+	return enabled_set.size() == 0 && sleep_set.size() != 0;
+}
+
+/**
+ * @brief Deprioritize a Thread that is spinning: it only runs when no
+ * other Thread can
+ * @param t The Thread to deprioritize
+ */
+void Scheduler::add_spinning(Thread *t)
+{
+	DEBUG("thread %d\n", id_to_int(t->get_id()));
+	set_enabled(t, THREAD_SPINNING);
+}
+
+/**
+ * @brief Give a spinning Thread its normal priority back
+ * @param t The Thread
+ */
+void Scheduler::remove_spinning(Thread *t)
+{
+	DEBUG("thread %d\n", id_to_int(t->get_id()));
+	set_enabled(t, THREAD_ENABLED);
+}
+
+bool Scheduler::is_spinning(thread_id_t tid) const
+{
+	int id = id_to_int(tid);
+	return id < enabled_len && enabled[id] == THREAD_SPINNING;
 }
 
 enabled_type_t Scheduler::get_enabled(const Thread *t) const
@@ -201,37 +256,29 @@ void Scheduler::wake(Thread *t)
 }
 
 /**
- * @brief Select a Thread to run via round-robin
- *
+ * @brief Select a Thread to run, as chosen by the Fuzzer
  *
  * @return The next Thread to run
  */
 Thread * Scheduler::select_next_thread()
 {
-	int avail_threads = 0;
-	int sleep_threads = 0;
-	int thread_list[enabled_len], sleep_list[enabled_len];
 	Thread * thread;
 
-	for (int i = 0;i < enabled_len;i++) {
-		if (enabled[i] == THREAD_ENABLED)
-			thread_list[avail_threads++] = i;
-		else if (enabled[i] == THREAD_SLEEP_SET)
-			sleep_list[sleep_threads++] = i;
-	}
-
-	if (avail_threads == 0 && !execution->getFuzzer()->has_paused_threads()) {
-		if (sleep_threads != 0) {
-			// No threads available, but some threads sleeping. Wake up one of them
-			thread = execution->getFuzzer()->selectThread(sleep_list, sleep_threads);
-			remove_sleep(thread);
-			thread->set_wakeup_state(true);
+	if (enabled_set.size() == 0 && !execution->getFuzzer()->has_paused_threads()) {
+		if (sleep_set.size() != 0) {
+			// No threads available, but some threads sleeping. Skip ahead to
+			// the first deadline and run one of the threads it wakes up
+			execution->skip_to_next_wakeup();
+			thread = execution->getFuzzer()->selectThread(&enabled_set);
+		} else if (spin_set.size() != 0) {
+			// Only spinning threads can run
+			thread = execution->getFuzzer()->selectThread(&spin_set);
 		} else {
 			return NULL;	// No threads available and no threads sleeping.
 		}
 	} else {
 		// Some threads are available
-		thread = execution->getFuzzer()->selectThread(thread_list, avail_threads);
+		thread = execution->getFuzzer()->selectThread(&enabled_set);
 	}
 
 	//curr_thread_index = id_to_int(thread->get_id());
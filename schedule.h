@@ -8,11 +8,13 @@
 #include "mymemory.h"
 #include "modeltypes.h"
 #include "classlist.h"
+#include "threadset.h"
 
 typedef enum enabled_type {
 	THREAD_DISABLED,
 	THREAD_ENABLED,
-	THREAD_SLEEP_SET
+	THREAD_SLEEP_SET,
+	THREAD_SPINNING
 } enabled_type_t;
 
 void enabled_type_to_string(enabled_type_t e, char *str);
@@ -41,8 +43,17 @@ public:
 	bool is_sleep_set(const Thread *t) const;
 	bool is_sleep_set(thread_id_t tid) const;
 	bool all_threads_sleeping() const;
+	void add_spinning(Thread *t);
+	void remove_spinning(Thread *t);
+	bool is_spinning(thread_id_t tid) const;
+	/** @return The number of spinning threads */
+	int num_spinning() const { return spin_set.size(); }
 	void set_scheduler_thread(thread_id_t tid);
 
+	/** @return The first thread index >= i that may be ready, or -1 */
+	int next_ready(int i) const { return ready.next(i); }
+	void remove_ready(Thread *t);
+
 	SNAPSHOTALLOC
 private:
 	ModelExecution *execution;
@@ -52,6 +63,19 @@ private:
 	int curr_thread_index;
 	void set_enabled(Thread *t, enabled_type_t enabled_status);
 
+	/** Threads that are THREAD_ENABLED */
+	ThreadSet enabled_set;
+	/** Threads that are THREAD_SLEEP_SET */
+	ThreadSet sleep_set;
+	/** Threads that are THREAD_SPINNING */
+	ThreadSet spin_set;
+	/**
+	 * Threads ModelChecker::getNextThread() must visit: all threads,
+	 * except freed threads and disabled threads with a pending action,
+	 * until the Scheduler enables them again
+	 */
+	ThreadSet ready;
+
 	/** The currently-running Thread */
 	Thread *current;
 };
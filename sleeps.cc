@@ -4,6 +4,7 @@
 
 #include "action.h"
 #include "model.h"
+#include "execution.h"
 
 extern "C" {
 int nanosleep(const struct timespec *rqtp, struct timespec *rmtp);
@@ -46,17 +47,15 @@ int usleep(useconds_t useconds)
 int nanosleep(const struct timespec *rqtp, struct timespec *rmtp)
 {
 	if (model) {
+		/* Sleeps are timed on the execution's virtual clock, so they never
+		 * wait in real time */
 		uint64_t time = rqtp->tv_sec * 1000000000 + rqtp->tv_nsec;
-		struct timespec currtime;
-		clock_gettime(CLOCK_MONOTONIC, &currtime);
-		uint64_t lcurrtime = currtime.tv_sec * 1000000000 + currtime.tv_nsec;
+		uint64_t lcurrtime = model->get_execution()->get_virtual_time();
 		model->switch_thread(new ModelAction(THREAD_SLEEP, std::memory_order_seq_cst, time, lcurrtime));
+		/* The sleep always runs to completion */
 		if (rmtp != NULL) {
-			clock_gettime(CLOCK_MONOTONIC, &currtime);
-			uint64_t lendtime = currtime.tv_sec * 1000000000 + currtime.tv_nsec;
-			uint64_t elapsed = lendtime - lcurrtime;
-			rmtp->tv_sec = elapsed / 1000000000;
-			rmtp->tv_nsec = elapsed - rmtp->tv_sec * 1000000000;
+			rmtp->tv_sec = 0;
+			rmtp->tv_nsec = 0;
 		}
 	}
 
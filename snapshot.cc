@@ -154,7 +154,8 @@ static void fork_loop() {
 			DEBUG("parent PID: %d, child PID: %d, snapshot ID: %d\n",
 						getpid(), forkedID, snapshotid);
 
-			while (waitpid(forkedID, NULL, 0) < 0) {
+			int status;
+			while (waitpid(forkedID, &status, 0) < 0) {
 				/* waitpid() may be interrupted */
 				if (errno != EINTR) {
 					perror("waitpid");
@@ -162,8 +163,13 @@ static void fork_loop() {
 				}
 			}
 
-			if (fork_snap->mIDToRollback != snapshotid)
-				_Exit(EXIT_SUCCESS);
+			if (fork_snap->mIDToRollback != snapshotid) {
+				/* The child either finished the last execution or died */
+				if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS)
+					_Exit(EXIT_SUCCESS);
+				if (!model->recover_from_crash(forkedID, status))
+					_Exit(EXIT_SUCCESS);
+			}
 		}
 	}
 }
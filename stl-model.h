@@ -2,6 +2,7 @@
 #define __STL_MODEL_H__
 
 #include <list>
+#include <strings.h>
 #include "mymemory.h"
 typedef unsigned int uint;
 
@@ -172,7 +173,7 @@ public:
 	_Tp getVal() {return val;}
 	sllnode<_Tp> * getNext() {return next;}
 	sllnode<_Tp> * getPrev() {return prev;}
-	SNAPSHOTALLOC;
+	SNAPSHOTSLABALLOC(sllnode<_Tp>);
 
 private:
 	sllnode<_Tp> * next;
@@ -461,19 +462,25 @@ private:
 };
 
 
-template<typename type>
+/**
+ * @brief A vector in the snapshotting heap
+ *
+ * The allocation functions may be overridden, e.g., with the region
+ * allocator for scratch vectors whose memory need not outlive the execution.
+ */
+template<typename type, void * (*_malloc)(size_t) = snapshot_malloc, void * (*_realloc)(void *, size_t) = snapshot_realloc, void (*_free)(void *) = snapshot_free>
 class SnapVector {
 public:
 	SnapVector(uint _capacity = VECTOR_DEFCAP) :
 		_size(0),
 		capacity(_capacity),
-		array((type *) snapshot_malloc(sizeof(type) * _capacity)) {
+		array((type *) _malloc(sizeof(type) * _capacity)) {
 	}
 
 	SnapVector(uint _capacity, type *_array)  :
 		_size(_capacity),
 		capacity(_capacity),
-		array((type *) snapshot_malloc(sizeof(type) * _capacity)) {
+		array((type *) _malloc(sizeof(type) * _capacity)) {
 		memcpy(array, _array, capacity * sizeof(type));
 	}
 	void pop_back() {
@@ -489,7 +496,7 @@ public:
 			_size = psize;
 			return;
 		} else if (psize > capacity) {
-			array = (type *)snapshot_realloc(array, (psize <<1 )* sizeof(type));
+			array = (type *)_realloc(array, (psize <<1 )* sizeof(type));
 			capacity = psize << 1;
 		}
 		bzero(&array[_size], (psize - _size) * sizeof(type));
@@ -499,7 +506,7 @@ public:
 	void push_back(type item) {
 		if (_size >= capacity) {
 			uint newcap = capacity << 1;
-			array = (type *)snapshot_realloc(array, newcap * sizeof(type));
+			array = (type *)_realloc(array, newcap * sizeof(type));
 			capacity = newcap;
 		}
 		array[_size++] = item;
@@ -560,14 +567,28 @@ public:
 	}
 
 	~SnapVector() {
-		snapshot_free(array);
+		_free(array);
 	}
 
 	void clear() {
 		_size = 0;
 	}
 
-	SNAPSHOTALLOC;
+	void * operator new(size_t size) {
+		return _malloc(size);
+	}
+	void operator delete(void *p, size_t size) {
+		_free(p);
+	}
+	void * operator new[](size_t size) {
+		return _malloc(size);
+	}
+	void operator delete[](void *p, size_t size) {
+		_free(p);
+	}
+	void * operator new(size_t size, void *p) {	/* placement new */
+		return p;
+	}
 private:
 	uint _size;
 	uint capacity;
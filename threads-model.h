@@ -141,6 +141,7 @@ public:
 #endif
 private:
 	int create_context();
+	void resume_context();
 
 	/** @brief The parent Thread which created this Thread */
 	Thread * const parent;
@@ -168,6 +169,15 @@ private:
 
 	void *arg;
 	ucontext_t context;
+#ifdef HAVE_FAST_CONTEXT
+	/**
+	 * @brief Stack pointer saved by model_context_switch(), or NULL
+	 *
+	 * Non-NULL while this thread is suspended by the fast context switch;
+	 * otherwise, a suspended thread is resumed from its ucontext.
+	 */
+	void *saved_sp;
+#endif
 	void *stack;
 	uint32_t stack_size;
 #ifdef TLS
@@ -176,8 +186,10 @@ public:
 	char *tls;
 	ucontext_t helpercontext;
 	pthread_mutex_t mutex;
+	pthread_cond_t cond;
 	pthread_mutex_t mutex2;
 	pthread_t thread;
+	void *thread_stack;
 private:
 #endif
 	thrd_t *user_thread;
@@ -205,6 +217,8 @@ void tlsdestructor(void *v);
 
 Thread * thread_current();
 thread_id_t thread_current_id();
+void stack_pool_init(size_t stacksize, unsigned int prefault);
+size_t stack_pool_stacksize();
 void thread_startup();
 void initMainThread();
 
@@ -237,6 +251,9 @@ int real_epoll_wait(int epfd, struct epoll_event *events, int maxevents, int tim
 int real_pthread_mutex_init(pthread_mutex_t *__mutex, const pthread_mutexattr_t *__mutexattr);
 int real_pthread_mutex_lock (pthread_mutex_t *__mutex);
 int real_pthread_mutex_unlock (pthread_mutex_t *__mutex);
+int real_pthread_cond_init (pthread_cond_t *__cond, const pthread_condattr_t *__cond_attr);
+int real_pthread_cond_wait (pthread_cond_t *__cond, pthread_mutex_t *__mutex);
+int real_pthread_cond_signal (pthread_cond_t *__cond);
 int real_pthread_create (pthread_t *__restrict __newthread, const pthread_attr_t *__restrict __attr, void *(*__start_routine)(void *), void *__restrict __arg);
 int real_pthread_join (pthread_t __th, void ** __thread_return);
 void real_pthread_exit (void * value_ptr) __attribute__((noreturn));
@@ -3,6 +3,7 @@
  */
 
 #include <string.h>
+#include <sys/mman.h>
 
 #include <threads.h>
 #include "mutex.h"
@@ -36,16 +37,149 @@ static void set_tls_addr(uintptr_t addr) {
 }
 #endif
 
+/**
+ * @brief Pool of thread stacks, recycled across threads and executions
+ *
+ * The slots live in one shared mapping made before the first fork, so every
+ * execution reuses the same physical pages instead of faulting in fresh
+ * zeroed ones. Each slot is a PROT_NONE guard page followed by the stack.
+ * The free list itself is private memory, so each execution starts from the
+ * free list as it stood at the fork.
+ */
+struct stack_pool {
+	char *base;
+	size_t stacksize;
+	size_t slotsize;
+	unsigned int prefault;
+	unsigned int numfree;
+	char *freelist[STACK_POOL_SLOTS];
+};
+
+/** @brief Stacks for the model-checker's user contexts */
+static struct stack_pool stackpool;
+
+#ifdef TLS
+/**
+ * @brief Stacks for the real helper pthreads
+ *
+ * glibc places a thread's static TLS block and descriptor at the top of a
+ * caller-supplied stack, so these slots also recycle the TLS blocks; glibc
+ * re-initializes them on each pthread_create().
+ */
+static struct stack_pool helperpool;
+#endif
+
+static void pool_setup(struct stack_pool *pool, size_t stacksize, unsigned int prefault)
+{
+	pool->stacksize = (stacksize + PAGESIZE - 1) & ~((size_t)PAGESIZE - 1);
+	pool->slotsize = pool->stacksize + PAGESIZE;
+	pool->prefault = prefault;
+	pool->base = (char *)mmap(NULL, pool->slotsize * STACK_POOL_SLOTS, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (pool->base == MAP_FAILED) {
+		perror("mmap");
+		exit(EXIT_FAILURE);
+	}
+	/* Hand out low slots first */
+	for (int i = STACK_POOL_SLOTS - 1;i >= 0;i--) {
+		char *slot = pool->base + pool->slotsize * i;
+		if (mprotect(slot, PAGESIZE, PROT_NONE)) {
+			perror("mprotect");
+			exit(EXIT_FAILURE);
+		}
+		pool->freelist[pool->numfree++] = slot + PAGESIZE;
+	}
+}
+
+/** Fault in the top pages of a stack, as configured */
+static void pool_prefault(struct stack_pool *pool, char *stack)
+{
+	size_t len = (size_t)pool->prefault * PAGESIZE;
+	if (len == 0)
+		return;
+	if (len > pool->stacksize)
+		len = pool->stacksize;
+	char *start = stack + pool->stacksize - len;
+#ifdef MADV_POPULATE_WRITE
+	if (!madvise(start, len, MADV_POPULATE_WRITE))
+		return;
+#endif
+	for (size_t off = 0;off < len;off += PAGESIZE)
+		((volatile char *)start)[off] = 0;
+}
+
+static void * pool_allocate(struct stack_pool *pool)
+{
+	char *stack;
+	if (pool->numfree > 0) {
+		stack = pool->freelist[--pool->numfree];
+	} else {
+		/* Pool exhausted; map a private slot for this execution only */
+		char *slot = (char *)mmap(NULL, pool->slotsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (slot == MAP_FAILED) {
+			perror("mmap");
+			exit(EXIT_FAILURE);
+		}
+		if (mprotect(slot, PAGESIZE, PROT_NONE)) {
+			perror("mprotect");
+			exit(EXIT_FAILURE);
+		}
+		stack = slot + PAGESIZE;
+	}
+	pool_prefault(pool, stack);
+	return stack;
+}
+
+static void pool_free(struct stack_pool *pool, void *stack)
+{
+	char *s = (char *)stack;
+	if (s >= pool->base && s < pool->base + pool->slotsize * STACK_POOL_SLOTS)
+		pool->freelist[pool->numfree++] = s;
+	else
+		munmap(s - PAGESIZE, pool->slotsize);
+}
+
+/**
+ * @brief Set up the stack pools
+ * @param stacksize The size of each thread stack, in bytes
+ * @param prefault The number of pages at the top of a stack to fault in when
+ * it is handed out
+ */
+void stack_pool_init(size_t stacksize, unsigned int prefault)
+{
+	ASSERT(!stackpool.base);
+	pool_setup(&stackpool, stacksize, prefault);
+#ifdef TLS
+	/* Helper pthreads run the user code, so keep the default pthread
+	 * stack size for them */
+	pthread_attr_t attr;
+	size_t helpersize;
+	pthread_attr_init(&attr);
+	pthread_attr_getstacksize(&attr, &helpersize);
+	pthread_attr_destroy(&attr);
+	pool_setup(&helperpool, helpersize, prefault);
+#endif
+}
+
+/** @return The size of the stacks stack_allocate() hands out */
+size_t stack_pool_stacksize()
+{
+	if (!stackpool.base)
+		stack_pool_init(STACK_SIZE, 0);
+	return stackpool.stacksize;
+}
+
 /** Allocate a stack for a new thread. */
-static void * stack_allocate(size_t size)
+static void * stack_allocate()
 {
-	return Thread_malloc(size);
+	if (!stackpool.base)
+		stack_pool_init(STACK_SIZE, 0);
+	return pool_allocate(&stackpool);
 }
 
 /** Free a stack for a terminated thread. */
 static void stack_free(void *stack)
 {
-	Thread_free(stack);
+	pool_free(&stackpool, stack);
 }
 
 /**
@@ -136,6 +270,24 @@ int real_pthread_mutex_unlock (pthread_mutex_t *__mutex) {
 	return pthread_mutex_unlock_p(__mutex);
 }
 
+static int (*pthread_cond_init_p) (pthread_cond_t *__cond, const pthread_condattr_t *__cond_attr) = NULL;
+
+int real_pthread_cond_init (pthread_cond_t *__cond, const pthread_condattr_t *__cond_attr) {
+	return pthread_cond_init_p(__cond, __cond_attr);
+}
+
+static int (*pthread_cond_wait_p) (pthread_cond_t *__cond, pthread_mutex_t *__mutex) = NULL;
+
+int real_pthread_cond_wait (pthread_cond_t *__cond, pthread_mutex_t *__mutex) {
+	return pthread_cond_wait_p(__cond, __mutex);
+}
+
+static int (*pthread_cond_signal_p) (pthread_cond_t *__cond) = NULL;
+
+int real_pthread_cond_signal (pthread_cond_t *__cond) {
+	return pthread_cond_signal_p(__cond);
+}
+
 static int (*pthread_create_p) (pthread_t *__restrict, const pthread_attr_t *__restrict, void *(*)(void *), void * __restrict) = NULL;
 
 int real_pthread_create (pthread_t *__restrict __newthread, const pthread_attr_t *__restrict __attr, void *(*__start_routine)(void *), void *__restrict __arg) {
@@ -184,6 +336,27 @@ void real_init_all() {
 			exit(EXIT_FAILURE);
 		}
 	}
+	if (!pthread_cond_init_p) {
+		pthread_cond_init_p = (int (*)(pthread_cond_t *__cond, const pthread_condattr_t *__cond_attr))dlsym(RTLD_NEXT, "pthread_cond_init");
+		if ((error = dlerror()) != NULL) {
+			fputs(error, stderr);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (!pthread_cond_wait_p) {
+		pthread_cond_wait_p = (int (*)(pthread_cond_t *__cond, pthread_mutex_t *__mutex))dlsym(RTLD_NEXT, "pthread_cond_wait");
+		if ((error = dlerror()) != NULL) {
+			fputs(error, stderr);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (!pthread_cond_signal_p) {
+		pthread_cond_signal_p = (int (*)(pthread_cond_t *__cond))dlsym(RTLD_NEXT, "pthread_cond_signal");
+		if ((error = dlerror()) != NULL) {
+			fputs(error, stderr);
+			exit(EXIT_FAILURE);
+		}
+	}
 	if (!pthread_create_p) {
 		pthread_create_p = (int (*)(pthread_t *__restrict, const pthread_attr_t *__restrict, void *(*)(void *), void *__restrict))dlsym(RTLD_NEXT, "pthread_create");
 		if ((error = dlerror()) != NULL) {
@@ -213,12 +386,13 @@ void finalize_helper_thread() {
 	Thread * curr_thread = thread_current();
 	real_pthread_mutex_lock(&curr_thread->mutex);
 	curr_thread->tls = (char *) get_tls_addr();
+	real_pthread_cond_signal(&curr_thread->cond);
 	real_pthread_mutex_unlock(&curr_thread->mutex);
 	//Wait in the kernel until it is time for us to finish
 	real_pthread_mutex_lock(&curr_thread->mutex2);
 	real_pthread_mutex_unlock(&curr_thread->mutex2);
 	//return to helper thread function
-	setcontext(&curr_thread->context);
+	curr_thread->resume_context();
 }
 
 void * helper_thread(void * ptr) {
@@ -236,9 +410,9 @@ void * helper_thread(void * ptr) {
 
 
 	/* Initialize new managed context */
-	curr_thread->helper_stack = stack_allocate(STACK_SIZE);
+	curr_thread->helper_stack = stack_allocate();
 	curr_thread->helpercontext.uc_stack.ss_sp = curr_thread->helper_stack;
-	curr_thread->helpercontext.uc_stack.ss_size = STACK_SIZE;
+	curr_thread->helpercontext.uc_stack.ss_size = stack_pool_stacksize();
 	curr_thread->helpercontext.uc_stack.ss_flags = 0;
 	curr_thread->helpercontext.uc_link = NULL;
 	makecontext(&curr_thread->helpercontext, finalize_helper_thread, 0);
@@ -277,21 +451,26 @@ void setup_context() {
 
 	/* Initialize our lock */
 	real_pthread_mutex_init(&curr_thread->mutex, NULL);
+	real_pthread_cond_init(&curr_thread->cond, NULL);
 	real_pthread_mutex_init(&curr_thread->mutex2, NULL);
 	real_pthread_mutex_lock(&curr_thread->mutex2);
 
-	/* Create the real thread */
-	real_pthread_create(&curr_thread->thread, NULL, helper_thread, NULL);
-	bool notdone = true;
-	while(notdone) {
-		real_pthread_mutex_lock(&curr_thread->mutex);
-		if (curr_thread->tls != NULL)
-			notdone = false;
-		real_pthread_mutex_unlock(&curr_thread->mutex);
-	}
+	/* Create the real thread, on a pooled stack that also holds its TLS */
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	curr_thread->thread_stack = pool_allocate(&helperpool);
+	pthread_attr_setstack(&attr, curr_thread->thread_stack, helperpool.stacksize);
+	real_pthread_create(&curr_thread->thread, &attr, helper_thread, NULL);
+	pthread_attr_destroy(&attr);
+
+	/* Sleep until the helper has handed over its TLS */
+	real_pthread_mutex_lock(&curr_thread->mutex);
+	while (curr_thread->tls == NULL)
+		real_pthread_cond_wait(&curr_thread->cond, &curr_thread->mutex);
+	real_pthread_mutex_unlock(&curr_thread->mutex);
 
 	set_tls_addr((uintptr_t)curr_thread->tls);
-	setcontext(&curr_thread->context);
+	curr_thread->resume_context();
 }
 #endif
 
@@ -307,11 +486,15 @@ int Thread::create_context()
 	ret = getcontext(&context);
 	if (ret)
 		return ret;
+#ifdef HAVE_FAST_CONTEXT
+	saved_sp = NULL;
+#endif
 
 	/* Initialize new managed context */
-	stack = stack_allocate(STACK_SIZE);
+	stack = stack_allocate();
+	stack_size = stack_pool_stacksize();
 	context.uc_stack.ss_sp = stack;
-	context.uc_stack.ss_size = STACK_SIZE;
+	context.uc_stack.ss_size = stack_size;
 	context.uc_stack.ss_flags = 0;
 	context.uc_link = NULL;
 #ifdef TLS
@@ -337,6 +520,9 @@ int Thread::swap(Thread *t, ucontext_t *ctxt)
 	t->set_state(THREAD_READY);
 #ifdef TLS
 	set_tls_addr((uintptr_t)model->getInitThread()->tls);
+#endif
+#ifdef HAVE_FAST_CONTEXT
+	t->saved_sp = NULL;
 #endif
 	return model_swapcontext(&t->context, ctxt);
 }
@@ -355,6 +541,20 @@ int Thread::swap(ucontext_t *ctxt, Thread *t)
 #ifdef TLS
 	if (t->tls != NULL)
 		set_tls_addr((uintptr_t)t->tls);
+#endif
+#ifdef HAVE_FAST_CONTEXT
+	if (t->saved_sp != NULL) {
+		/* volatile, so that 'resumed' isn't promoted to a register */
+		volatile bool resumed = false;
+		getcontext(ctxt);
+		if (!resumed) {
+			resumed = true;
+			void *sp = t->saved_sp;
+			t->saved_sp = NULL;
+			model_context_resume(sp);
+		}
+		return 0;
+	}
 #endif
 	return model_swapcontext(ctxt, &t->context);
 }
@@ -369,7 +569,34 @@ int Thread::swap(Thread *t, Thread *t2)
 	if (t2->tls != NULL)
 		set_tls_addr((uintptr_t)t2->tls);
 #endif
+#ifdef HAVE_FAST_CONTEXT
+	void *sp = t2->saved_sp;
+	if (sp != NULL) {
+		t2->saved_sp = NULL;
+		return model_context_switch(&t->saved_sp, sp);
+	}
+	return model_context_switch_ucontext(&t->saved_sp, &t2->context);
+#else
 	return model_swapcontext(&t->context, &t2->context);
+#endif
+}
+
+/**
+ * @brief Abandon the current context and resume this Thread's context
+ *
+ * Used where the caller is finished with its own context, e.g., when the
+ * helper thread that gave this Thread its TLS returns to it.
+ */
+void Thread::resume_context()
+{
+#ifdef HAVE_FAST_CONTEXT
+	void *sp = saved_sp;
+	if (sp != NULL) {
+		saved_sp = NULL;
+		model_context_resume(sp);
+	}
+#endif
+	setcontext(&context);
 }
 
 /** Terminate a thread. */
@@ -388,6 +615,7 @@ void Thread::freeResources() {
 		real_pthread_mutex_unlock(&mutex2);
 		real_pthread_join(thread, NULL);
 		stack_free(helper_stack);
+		pool_free(&helperpool, thread_stack);
 	}
 #endif
 	state = THREAD_FREED;
@@ -420,6 +648,9 @@ Thread::Thread(thread_id_t tid) :
 	model_thread(true)
 {
 	memset(&context, 0, sizeof(context));
+#ifdef HAVE_FAST_CONTEXT
+	saved_sp = NULL;
+#endif
 }
 
 /**
@@ -528,6 +759,7 @@ Thread * Thread::waiting_on() const
 		case PTHREAD_JOIN:
 			return pending->get_thread_operand();
 		case ATOMIC_LOCK:
+		case ATOMIC_TIMEDLOCK:
 			return (Thread *)pending->get_mutex()->get_state()->locked;
 		default:
 			return NULL;
@@ -0,0 +1,111 @@
+/** @file threadset.h
+ *  @brief A set of thread indices, stored as a bitmap.
+ */
+
+#ifndef __THREADSET_H__
+#define __THREADSET_H__
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "mymemory.h"
+
+/**
+ * @brief A set of zero-based thread indices
+ *
+ * Membership updates are O(1); size() is O(1); finding the k-th member or the
+ * next member after an index is O(words), i.e., one popcount or one scan per
+ * 64 threads.
+ */
+class ThreadSet {
+public:
+	ThreadSet() : words(NULL), numwords(0), count(0) { }
+
+	/** @brief Add index i to the set */
+	void add(int i) {
+		int w = i >> 6;
+		if (w >= numwords)
+			grow(w + 1);
+		uint64_t bit = ((uint64_t)1) << (i & 63);
+		if (!(words[w] & bit)) {
+			words[w] |= bit;
+			count++;
+		}
+	}
+
+	/** @brief Remove index i from the set */
+	void remove(int i) {
+		int w = i >> 6;
+		if (w >= numwords)
+			return;
+		uint64_t bit = ((uint64_t)1) << (i & 63);
+		if (words[w] & bit) {
+			words[w] &= ~bit;
+			count--;
+		}
+	}
+
+	bool contains(int i) const {
+		int w = i >> 6;
+		return w < numwords && (words[w] >> (i & 63)) & 1;
+	}
+
+	/** @return The number of members */
+	int size() const { return count; }
+
+	/**
+	 * @brief Find the k-th smallest member
+	 * @param k A rank in [0, size())
+	 * @return The member of rank k
+	 */
+	int select(int k) const {
+		for (int w = 0;w < numwords;w++) {
+			int pop = __builtin_popcountll(words[w]);
+			if (k < pop) {
+				uint64_t word = words[w];
+				while (k--)
+					word &= word - 1;
+				return (w << 6) + __builtin_ctzll(word);
+			}
+			k -= pop;
+		}
+		return -1;
+	}
+
+	/**
+	 * @brief Find the smallest member that is at least i
+	 * @return The member, or -1 if there is none
+	 */
+	int next(int i) const {
+		int w = i >> 6;
+		if (w >= numwords)
+			return -1;
+		uint64_t word = words[w] & (~((uint64_t)0) << (i & 63));
+		while (true) {
+			if (word)
+				return (w << 6) + __builtin_ctzll(word);
+			if (++w >= numwords)
+				return -1;
+			word = words[w];
+		}
+	}
+
+	SNAPSHOTALLOC
+private:
+	void grow(int n) {
+		uint64_t *newwords = (uint64_t *)snapshot_malloc(sizeof(uint64_t) * n);
+		memset(&newwords[numwords], 0, (n - numwords) * sizeof(uint64_t));
+		if (words != NULL) {
+			memcpy(newwords, words, numwords * sizeof(uint64_t));
+			snapshot_free(words);
+		}
+		words = newwords;
+		numwords = n;
+	}
+
+	uint64_t *words;
+	int numwords;
+	int count;
+};
+
+#endif	/* __THREADSET_H__ */